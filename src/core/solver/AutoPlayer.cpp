@@ -7,11 +7,40 @@
 #include <QMutexLocker>
 #include <QTimer>
 
+#include <algorithm>
+
 #include "ProgressProxy.h"
 
+static QSharedPointer<SolutionCache> sharedSolutionCache()
+{
+    static QSharedPointer<SolutionCache> solutionCache = [] () {
+        QSharedPointer<SolutionCache> cache(new SolutionCache);
+        // openings look the same from any corner
+        cache->setCanonicalizeSymmetries(true);
+
+        return cache;
+    }();
+
+    return solutionCache;
+}
+
 AutoPlayer::AutoPlayer(QSharedPointer<Minefield> minefield)
-    : minefield(minefield)
+    : minefield(minefield), regionCache(new RegionCache), solutionCache(sharedSolutionCache())
 {
+    speculationPool.setMaxThreadCount(1);
+    speculationPool.setThreadPriority(QThread::LowPriority);
+}
+
+AutoPlayer::~AutoPlayer()
+{
+    cancelSpeculations();
+
+    waitForSpeculations();
+}
+
+void AutoPlayer::waitForSpeculations()
+{
+    speculationPool.waitForDone();
 }
 
 void AutoPlayer::queueStep()
@@ -64,6 +93,20 @@ double AutoPlayer::getBestMineChance() const
     return bestMineChance;
 }
 
+void AutoPlayer::setSpeculativeCellCount(int count)
+{
+    QMutexLocker locker(&writeMutex);
+
+    speculativeCellCount = count;
+}
+
+void AutoPlayer::setSpeculativeOutcomeCount(int count)
+{
+    QMutexLocker locker(&writeMutex);
+
+    speculativeOutcomeCount = count;
+}
+
 void AutoPlayer::step()
 {
     QMutexLocker locker(&writeMutex);
@@ -93,12 +136,36 @@ void AutoPlayer::calculate()
     {
         calculationPending = false;
 
-        QSharedPointer<Solver> solver(new Solver(minefield, finishedSolver? finishedSolver->getChancesToBeMine() : QHash<Coordinate, double>{}));
+        QSharedPointer<Solver> solver;
+        QFuture<void> mineChancesFuture;
+
+        QByteArray revealedMinefield = minefield->getRevealedMinefield();
 
-        QFuture<void> mineChancesFuture = QtConcurrent::run([solver] ()
+        for(const Speculation &speculation : speculations)
         {
-            solver->computeSolution();
-        });
+            // only a finished speculation is picked up, one still going or waiting is on the low priority thread and would hold up the reveal
+            // starting over loses little, its regions are in the cache as soon as they're solved
+            if(speculation.revealedMinefield == revealedMinefield && speculation.future.isFinished() && !speculation.solver->isCancelled())
+            {// this board was seen coming, its solve is already done
+                solver = speculation.solver;
+                mineChancesFuture = speculation.future;
+                break;
+            }
+        }
+
+        cancelSpeculations(solver);
+
+        if(!solver)
+        {
+            solver.reset(new Solver(minefield, finishedSolver? finishedSolver->getChancesToBeMine() : QHash<Coordinate, double>{}));
+            solver->setRegionCache(regionCache);
+            solver->setSolutionCache(solutionCache);
+
+            mineChancesFuture = QtConcurrent::run([solver] ()
+            {
+                solver->computeSolution();
+            });
+        }
 
         setActiveSolver(solver);
 
@@ -129,6 +196,10 @@ void AutoPlayer::onCalculationsComplete()
     {
         queueStep();
     }
+    else
+    {// a person takes a while to pick a cell, which is plenty of time to get ahead of them
+        speculate();
+    }
 
     emit calculationComplete(finishedSolver);
 }
@@ -198,3 +269,103 @@ void AutoPlayer::reveal(int x, int y)
 
     minefield->revealCell(x, y, true);
 }
+
+void AutoPlayer::speculate()
+{
+    cancelSpeculations();
+
+    if(speculativeCellCount <= 0 || speculativeOutcomeCount <= 0 || !minefield->isPopulated() || minefield->wasMineHit() || minefield->areAllCountCellsRevealed())
+    {
+        return;
+    }
+
+    const QHash<Coordinate, double> &chances = finishedSolver->getChancesToBeMine();
+
+    QList<Coordinate> cells;
+
+    for(auto iter = chances.constBegin(); iter != chances.constEnd(); ++iter)
+    {
+        if(iter.value() < 1 && minefield->getCell(iter.key().first, iter.key().second) == SpecialStatus::Unknown)
+        {
+            cells.append(iter.key());
+        }
+    }
+
+    // ties go by position, so the same board always speculates on the same cells
+    std::sort(cells.begin(), cells.end(), [&] (const Coordinate& a, const Coordinate& b) {
+        return chances[a] < chances[b] || (chances[a] == chances[b] && a < b);
+    });
+
+    SolverMinefield revealedMinefield(minefield->getRevealedMinefield(), minefield->getWidth(), minefield->getHeight());
+
+    for(int i = 0; i < cells.size() && i < speculativeCellCount; ++i)
+    {
+        for(int count : likelyCounts(cells[i], chances))
+        {
+            SolverMinefield outcome = revealedMinefield.chooseCount(cells[i].first, cells[i].second, count);
+
+            // the same previous chances as the solve after the reveal would use, so the results match it exactly
+            QSharedPointer<Solver> solver(new Solver(outcome, minefield->getMineCount(), chances));
+            solver->setRegionCache(regionCache);
+            solver->setSpeculative(true);
+            solver->setSolutionCache(solutionCache);
+
+            QFuture<void> future = QtConcurrent::run(&speculationPool, [solver] ()
+            {
+                solver->computeSolution();
+            });
+
+            speculations.append({outcome.getMinefieldBytes(), solver, future});
+        }
+    }
+}
+
+void AutoPlayer::cancelSpeculations(QSharedPointer<Solver> keptSolver)
+{
+    for(const Speculation &speculation : speculations)
+    {
+        if(speculation.solver != keptSolver)
+        {
+            speculation.solver->cancel();
+        }
+    }
+
+    speculations.clear();
+}
+
+QList<int> AutoPlayer::likelyCounts(const Coordinate &cell, const QHash<Coordinate, double> &chances) const
+{
+    // the adjacent cells are taken as independent, so the chance of each count builds up one adjacent cell at a time
+    // revealed cells aren't in the chances and count as clear
+    QVector<double> countChances = {1};
+
+    minefield->traverseAdjacentCells(cell.first, cell.second, [&] (int x, int y) -> void {
+        double mineChance = chances.value({x, y}, 0);
+
+        countChances.append(0);
+
+        for(int count = countChances.size() - 1; count > 0; --count)
+        {
+            countChances[count] = countChances[count] * (1 - mineChance) + countChances[count - 1] * mineChance;
+        }
+
+        countChances[0] *= 1 - mineChance;
+    });
+
+    // a 0 reveals its neighbors too, and what they show can't be foreseen
+    QList<int> counts;
+
+    for(int count = 1; count < countChances.size(); ++count)
+    {
+        if(countChances[count] > 0)
+        {
+            counts.append(count);
+        }
+    }
+
+    std::sort(counts.begin(), counts.end(), [&] (int a, int b) {
+        return countChances[a] > countChances[b];
+    });
+
+    return counts.mid(0, speculativeOutcomeCount);
+}
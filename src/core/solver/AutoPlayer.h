@@ -4,10 +4,14 @@
 #include <QObject>
 
 #include <QFutureWatcher>
+#include <QHash>
 #include <QMutex>
 #include <QSharedPointer>
+#include <QThreadPool>
 
 class Minefield;
+class RegionCache;
+class SolutionCache;
 class Solver;
 
 typedef QPair<int, int> Coordinate;
@@ -18,6 +22,7 @@ class AutoPlayer : public QObject
 
 public:
     explicit AutoPlayer(QSharedPointer<Minefield> minefield);
+    ~AutoPlayer();
 
     void queueStep();
     void queueCalculate();
@@ -30,6 +35,13 @@ public:
 
     double getBestMineChance() const;
 
+    // after each solve, the boards that revealing the few lowest risk cells most likely leads to are solved in the background
+    // a reveal that lands on one of them picks up its solve instead of starting over, 0 of either turns this off
+    void setSpeculativeCellCount(int count);
+    void setSpeculativeOutcomeCount(int count);
+    // blocks until every speculative solve is done, a reveal after this finds its speculation ready if there was one
+    void waitForSpeculations();
+
 signals:
     void maxProgressChanged(int max);
     void currentProgressChanged(int progress);
@@ -48,6 +60,26 @@ private:
     QSharedPointer<Solver> activeSolver;
     QSharedPointer<Solver> finishedSolver;
 
+    // a reveal only changes the regions around it, the rest are kept from one solve to the next
+    QSharedPointer<RegionCache> regionCache;
+    // shared by every auto player, so a board seen in an earlier game or before an undo is answered right away
+    QSharedPointer<SolutionCache> solutionCache;
+
+    // a solve started ahead of time for a board that might come next
+    struct Speculation
+    {
+        QByteArray revealedMinefield;
+        QSharedPointer<Solver> solver;
+        QFuture<void> future;
+    };
+
+    int speculativeCellCount = 3;
+    int speculativeOutcomeCount = 2;
+
+    QList<Speculation> speculations;
+    // a single low priority thread, so the speculative solves only take up cores nothing else wants
+    QThreadPool speculationPool;
+
     QSharedPointer<QFutureWatcher<void>> mineChancesCalculationWatcher;
 
     QList<QMetaObject::Connection> recalcProgressConnections;
@@ -63,6 +95,12 @@ private:
     void revealLowestRiskCells();
     QList<Coordinate> getOptimalCells() const;
     void reveal(int x, int y);
+
+    void speculate();
+    // cancels every speculative solve but the one being kept
+    void cancelSpeculations(QSharedPointer<Solver> keptSolver = {});
+    // the counts the cell is most likely to show if it's clear, most likely first
+    QList<int> likelyCounts(const Coordinate& cell, const QHash<Coordinate, double>& chances) const;
 };
 
 #endif // AUTOPLAYER_H
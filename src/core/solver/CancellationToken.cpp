@@ -0,0 +1,33 @@
+#include "CancellationToken.h"
+
+void CancellationToken::cancel()
+{
+    cancelled.storeRelaxed(1);
+}
+
+void CancellationToken::setDeadline(QDeadlineTimer newDeadline)
+{
+    deadline = newDeadline;
+}
+
+QDeadlineTimer CancellationToken::getDeadline() const
+{
+    return deadline;
+}
+
+bool CancellationToken::isCancelled() const
+{
+    if(cancelled.loadRelaxed())
+    {
+        return true;
+    }
+
+    if(deadline.hasExpired())
+    {
+        cancelled.storeRelaxed(1);
+
+        return true;
+    }
+
+    return false;
+}
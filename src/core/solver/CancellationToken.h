@@ -0,0 +1,27 @@
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+#include <QAtomicInt>
+#include <QDeadlineTimer>
+
+// lets a solve be stopped from another thread, right away or once its time runs out
+// the work checks it for every node, so a cancel is noticed within the time it takes to handle a single node
+class CancellationToken
+{
+public:
+    // safe to call from any thread, at any time
+    void cancel();
+    // has to be set before the work starts checking the token
+    void setDeadline(QDeadlineTimer newDeadline);
+    QDeadlineTimer getDeadline() const;
+
+    // once the deadline passes this stays cancelled even if the deadline is moved
+    bool isCancelled() const;
+
+private:
+    mutable QAtomicInt cancelled;
+
+    QDeadlineTimer deadline{QDeadlineTimer::Forever};
+};
+
+#endif // CANCELLATIONTOKEN_H
@@ -1,45 +1,434 @@
 #include "ChoiceColumn.h"
 
-#include "ChoiceNode.h"
-#include "SolverMinefield.h"
+#include "PathKernels.h"
+#include "SolverArena.h"
+#include "SolverMath.h"
 
 #include <QMutexLocker>
 #include <QThreadPool>
 #include <QDebug>
 #include <QtConcurrent/QtConcurrent>
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
 Q_GLOBAL_STATIC(QThreadPool, columnCalcThreadPool);
 
+// the exponent of a node that has no paths at all, it never wins when picking the largest exponent
+static const int NO_PATHS_EXPONENT = INT_MIN / 2;
+
+// the most powers of two a node's counts can spread across
+// kept well under the range of a double so that adding in counts from a node with a smaller exponent can't underflow either
+static const int PATH_RANGE_LIMIT = 480;
+
+// roughly what an entry of the state lookup costs along with its share of the buckets, Qt doesn't say exactly
+static const qsizetype HASH_ENTRY_BYTES = 4 * sizeof(void*);
+
+// a dense fringe only gets an array over its whole state space if the successors could fill a fair share of it
+// otherwise its indices are hashed like any other key, an array entry is a quarter of what a hash entry costs
+static const qint64 DENSE_LOOKUP_SLOTS_PER_SUCCESSOR = 4;
 
-ChoiceColumn::ChoiceColumn(int x, int y)
-    : x(x), y(y)
+static int windowSize(int min, int max)
 {
+    return max >= min? max - min + 1 : 0;
 }
 
-QSharedPointer<ChoiceNode> ChoiceColumn::getOrCreateChoiceNode(const SolverMinefield &minefield)
+template<typename T>
+static SolverFloat scaledToSolverFloat(const T &value, int exponent)
 {
-    // we use the state as a key to get the choice node that corresponds to that state
-    // technically if width could change we'd need the width factored in, but it can't so we don't
-    // this may need optimization since it doubles the memory footprint
-    auto node = choicesInColumn.value(minefield.getMinefieldBytes(), {});
+    if(value == 0)
+    {
+        return 0;
+    }
+
+    return boost::multiprecision::ldexp(SolverFloat(value), exponent);
+}
+
+template<>
+double *ChoiceColumn::PathCounts::values<double>(int nodeIndex)
+{
+    return scaled + offsets[nodeIndex];
+}
 
-    if(node.isNull())
+template<>
+const double *ChoiceColumn::PathCounts::values<double>(int nodeIndex) const
+{
+    return scaled + offsets[nodeIndex];
+}
+
+template<>
+SolverFloat *ChoiceColumn::PathCounts::values<SolverFloat>(int nodeIndex)
+{
+    return wide.data() + offsets[nodeIndex];
+}
+
+template<>
+const SolverFloat *ChoiceColumn::PathCounts::values<SolverFloat>(int nodeIndex) const
+{
+    return wide.constData() + offsets[nodeIndex];
+}
+
+template<>
+quint64 *ChoiceColumn::PathCounts::values<quint64>(int nodeIndex)
+{
+    return residues + offsets[nodeIndex];
+}
+
+template<>
+const quint64 *ChoiceColumn::PathCounts::values<quint64>(int nodeIndex) const
+{
+    return residues + offsets[nodeIndex];
+}
+
+// residues don't share the scaled pairing of the other counts, this is defined with the rest of the node functions
+template<>
+void ChoiceColumn::calculateWaysToBeMineForNode<quint64>(ChoiceNode *choiceNode, ChoiceColumn *column, const ChoiceColumn *nextColumn, int mineCount);
+
+
+ChoiceColumn::ChoiceColumn(int x, int y, const ColumnFringe &fringe, SolverArena *arena)
+    : arena(arena), x(x), y(y), fringe(fringe)
+{
+}
+
+ChoiceColumn::~ChoiceColumn()
+{
+    if(memoryBudget)
     {
-        node = node.create(minefield, x, y);
-        addChoiceNode(node);
+        memoryBudget->release(heldBytes.loadRelaxed() + lookupBytes.loadRelaxed());
+    }
+}
+
+ChoiceNode *ChoiceColumn::getOrCreateChoiceNode(const ColumnFringe &previousFringe, const ColumnFringe::FringeState &previousState, bool mine, ColumnFringe::FringeState &fringeState, qint64 discoveryOrder)
+{
+    // we use the state as a key to get the choice node that corresponds to that state
+    // the state only holds the counts of the column's fringe cells, everything else is the same for every node in the column
+    int shardIndex = stateShard(fringeState);
+    StateShard &shard = stateShards[shardIndex];
+
+    QMutexLocker locker(&shard.mutex);
+
+    ChoiceNode *node = nullptr;
+
+    if(denseStateSlots)
+    {// dense states are looked up directly by their index, no hashing required
+        node = denseStateSlots[fringeState.index];
+    }
+    else if(fringe.isDense())
+    {// the index is the whole state, so the first node under it is the one
+        node = shard.hashedStateLookup.value(fringeState.index, nullptr);
+    }
+    else
+    {// probe the states with the same hash, the successor is compared against them without building its counts
+        for(auto iter = shard.hashedStateLookup.constFind(fringeState.hash); iter != shard.hashedStateLookup.constEnd() && iter.key() == fringeState.hash; ++iter)
+        {
+            if(previousFringe.successorMatches(previousState, mine, iter.value()->getFringeState()))
+            {
+                node = iter.value();
+                break;
+            }
+        }
+    }
+
+    if(!node)
+    {// the state is genuinely new, the shard's lock also covers its part of the arena
+        SolverArena &shardArena = arena->getShard(shardIndex);
+
+        if(!fringe.isDense())
+        {// only now does it need its counts
+            fringeState.counts = shardArena.createArray<MineStatus>(fringe.size());
+
+            previousFringe.materializeSuccessorState(previousState, mine, fringeState);
+
+            node = shardArena.create<ChoiceNode>(fringeState);
+
+            shard.hashedStateLookup.insert(fringeState.hash, node);
+
+            holdArenaBytes(sizeof(ChoiceNode) + fringe.size() * sizeof(MineStatus));
+            holdLookupBytes(HASH_ENTRY_BYTES);
+        }
+        else if(denseStateSlots)
+        {
+            node = shardArena.create<ChoiceNode>(fringeState);
+
+            denseStateSlots[fringeState.index] = node;
+
+            holdArenaBytes(sizeof(ChoiceNode));
+        }
+        else
+        {
+            node = shardArena.create<ChoiceNode>(fringeState);
+
+            shard.hashedStateLookup.insert(fringeState.index, node);
+
+            holdArenaBytes(sizeof(ChoiceNode));
+            holdLookupBytes(HASH_ENTRY_BYTES);
+        }
     }
 
+    node->discover(discoveryOrder);
+
+    return node;
+}
+
+ChoiceNode *ChoiceColumn::createChoiceNode(const ColumnFringe::FringeState &fringeState)
+{
+    ChoiceNode *node = arena->create<ChoiceNode>(fringeState);
+
+    node->setIndex(choiceNodes.size());
+
+    choiceNodes.append(node);
+
+    holdArenaBytes(sizeof(ChoiceNode));
+    holdBytes(sizeof(ChoiceNode*));
+
     return node;
 }
 
-void ChoiceColumn::addChoiceNode(QSharedPointer<ChoiceNode> node)
+void ChoiceColumn::initializeStartingPathsBack(int mineCount)
+{
+    Q_UNUSED(mineCount);
+
+    // no mines have been placed before the start
+    backWindows.fill({0, 0}, choiceNodes.size());
+    allocatePathCounts(backWindows, pathsBack);
+
+    if(pathNumerics == PathNumerics::Exact)
+    {
+        pathsBack.residues[0] = 1;
+    }
+    else if(pathNumerics == PathNumerics::BinFloat)
+    {
+        pathsBack.wide[0] = 1;
+    }
+    else
+    {
+        pathsBack.scaled[0] = 1;
+    }
+
+    pathsBack.exponents[0] = 0;
+}
+
+QFuture<void> ChoiceColumn::generateSuccessors(ChoiceColumn &nextColumn, int mineCount)
+{
+    // every node has at most two successors, each gets a slot so no thread has to append to a shared list
+    successorSlots.fill(nullptr, 2 * choiceNodes.size());
+
+    holdBytes(successorSlots.size() * sizeof(ChoiceNode*));
+
+    if(nextColumn.fringe.isDense() && nextColumn.fringe.getStateSpaceSize() <= DENSE_LOOKUP_SLOTS_PER_SUCCESSOR * successorSlots.size())
+    {// the lookup has to exist before the threads start using it, and they only ever write through its data
+        nextColumn.denseStateLookup.fill(nullptr, nextColumn.fringe.getStateSpaceSize());
+        nextColumn.denseStateSlots = nextColumn.denseStateLookup.data();
+
+        nextColumn.holdLookupBytes(nextColumn.denseStateLookup.size() * sizeof(ChoiceNode*));
+    }
+
+    // map seems to hate lambdas
+    return QtConcurrent::map(&(*columnCalcThreadPool), choiceNodes, std::bind(&generateSuccessorsForNode, std::placeholders::_1, this, &nextColumn, successorSlots.data(), mineCount));
+}
+
+QFuture<void> ChoiceColumn::linkSuccessors(ChoiceColumn &nextColumn, int mineCount)
+{
+    // a successor's discovery order is the first slot that found it, so walking the slots in order numbers the nodes
+    // in the same order as building the column one node at a time would, which keeps solves reproducible
+    for(int slot = 0; slot < successorSlots.size(); ++slot)
+    {
+        ChoiceNode *successor = successorSlots[slot];
+
+        if(successor && successor->getDiscoveryOrder() == slot)
+        {
+            successor->setIndex(nextColumn.choiceNodes.size());
+            nextColumn.choiceNodes.append(successor);
+        }
+    }
+
+    forwardEdgeOffsets.reserve(choiceNodes.size() + 1);
+    forwardEdges.reserve(nextColumn.choiceNodes.size() * 2);
+
+    for(int i = 0; i < choiceNodes.size(); ++i)
+    {// the nodes are visited in order, so each node's edges land right after the previous node's
+        forwardEdgeOffsets.append(forwardEdges.size());
+
+        for(int choice = 0; choice < 2; ++choice)
+        {
+            ChoiceNode *successor = successorSlots[2 * i + choice];
+
+            if(successor)
+            {// the first slot is the mine choice, which costs a mine
+                forwardEdges.append({successor->getIndex(), choice == 0? 1 : 0});
+            }
+        }
+    }
+
+    forwardEdgeOffsets.append(forwardEdges.size());
+
+    holdBytes(forwardEdgeOffsets.size() * qsizetype(sizeof(int)) + forwardEdges.size() * qsizetype(sizeof(ChoiceNode::Edge)) - successorSlots.size() * qsizetype(sizeof(ChoiceNode*)));
+
+    successorSlots = QVector<ChoiceNode*>();
+
+    // a successor can have used anything its sources used plus the cost of the edge, but never more than the mine count
+    nextColumn.backWindows.fill(MineWindow(), nextColumn.choiceNodes.size());
+
+    nextColumn.holdBytes(nextColumn.choiceNodes.size() * (sizeof(ChoiceNode*) + sizeof(MineWindow)));
+
+    for(int source = 0; source < choiceNodes.size(); ++source)
+    {
+        const MineWindow &sourceWindow = backWindows[source];
+
+        for(int i = forwardEdgeOffsets[source]; i < forwardEdgeOffsets[source + 1]; ++i)
+        {
+            int low = sourceWindow.min + forwardEdges[i].cost;
+            int high = std::min(sourceWindow.max + forwardEdges[i].cost, mineCount);
+
+            if(low > high)
+            {
+                continue;
+            }
+
+            MineWindow &targetWindow = nextColumn.backWindows[forwardEdges[i].nodeIndex];
+
+            if(targetWindow.max < targetWindow.min)
+            {
+                targetWindow = {low, high};
+            }
+            else
+            {
+                targetWindow.min = std::min(targetWindow.min, low);
+                targetWindow.max = std::max(targetWindow.max, high);
+            }
+        }
+    }
+
+    return pushPathsBack(nextColumn, mineCount);
+}
+
+QFuture<void> ChoiceColumn::pushPathsBack(ChoiceColumn &nextColumn, int mineCount)
+{
+    // the next column's counts start at zero and collect the paths of every edge into them
+    nextColumn.allocatePathCounts(nextColumn.backWindows, nextColumn.pathsBack);
+
+    // the push into this column finished before this one started, so its incoming edges aren't needed anymore
+    releaseIncomingEdges();
+
+    nextColumn.gatherIncomingEdges(*this);
+
+    if(pathPushPartitions.isEmpty())
+    {
+        for(int i = 0; i < STATE_SHARD_COUNT; ++i)
+        {
+            pathPushPartitions.append(i);
+        }
+    }
+
+    if(pathNumerics == PathNumerics::Exact)
+    {
+        // map seems to hate lambdas
+        return QtConcurrent::map(&(*columnCalcThreadPool), pathPushPartitions, std::bind(&pushPathsBackForPartition<quint64>, std::placeholders::_1, this, &nextColumn, mineCount));
+    }
+    else if(pathNumerics == PathNumerics::BinFloat)
+    {
+        // map seems to hate lambdas
+        return QtConcurrent::map(&(*columnCalcThreadPool), pathPushPartitions, std::bind(&pushPathsBackForPartition<SolverFloat>, std::placeholders::_1, this, &nextColumn, mineCount));
+    }
+
+    // map seems to hate lambdas
+    return QtConcurrent::map(&(*columnCalcThreadPool), pathPushPartitions, std::bind(&pushPathsBackForPartition<double>, std::placeholders::_1, this, &nextColumn, mineCount));
+}
+
+void ChoiceColumn::gatherIncomingEdges(const ChoiceColumn &previousColumn)
 {
-    choicesInColumn.insert(node->getMinefield().getMinefieldBytes(), node);
+    // a counting sort by target, the sources are walked in order so each target's edges stay in source order
+    incomingEdgeOffsets.fill(0, choiceNodes.size() + 1);
+
+    for(const ChoiceNode::Edge &edge : previousColumn.forwardEdges)
+    {
+        ++incomingEdgeOffsets[edge.nodeIndex + 1];
+    }
+
+    for(int i = 0; i < choiceNodes.size(); ++i)
+    {
+        incomingEdgeOffsets[i + 1] += incomingEdgeOffsets[i];
+    }
+
+    incomingEdges.resize(previousColumn.forwardEdges.size());
+
+    QVector<int> nextSlots = incomingEdgeOffsets;
+
+    for(int source = 0; source < previousColumn.choiceNodes.size(); ++source)
+    {
+        for(int i = previousColumn.forwardEdgeOffsets[source]; i < previousColumn.forwardEdgeOffsets[source + 1]; ++i)
+        {
+            const ChoiceNode::Edge &edge = previousColumn.forwardEdges[i];
+
+            incomingEdges[nextSlots[edge.nodeIndex]++] = {source, edge.cost};
+        }
+    }
+
+    holdBytes(incomingEdgeOffsets.size() * qsizetype(sizeof(int)) + incomingEdges.size() * qsizetype(sizeof(ChoiceNode::Edge)));
 }
 
-QList<QSharedPointer<ChoiceNode> > ChoiceColumn::getChoiceNodes() const
+void ChoiceColumn::releaseIncomingEdges()
 {
-    return choicesInColumn.values();
+    holdBytes(-(incomingEdgeOffsets.size() * qsizetype(sizeof(int)) + incomingEdges.size() * qsizetype(sizeof(ChoiceNode::Edge))));
+
+    incomingEdgeOffsets = QVector<int>();
+    incomingEdges = QVector<ChoiceNode::Edge>();
+}
+
+void ChoiceColumn::releaseStateLookup()
+{
+    denseStateLookup = QVector<ChoiceNode*>();
+    denseStateSlots = nullptr;
+
+    for(StateShard &shard : stateShards)
+    {
+        shard.hashedStateLookup = QMultiHash<quint64, ChoiceNode*>();
+    }
+
+    holdLookupBytes(-lookupBytes.loadRelaxed());
+}
+
+void ChoiceColumn::releaseNodes()
+{
+    choiceNodes = QList<ChoiceNode*>();
+
+    forwardEdgeOffsets = QVector<int>();
+    forwardEdges = QVector<ChoiceNode::Edge>();
+    incomingEdgeOffsets = QVector<int>();
+    incomingEdges = QVector<ChoiceNode::Edge>();
+    successorSlots = QVector<ChoiceNode*>();
+
+    backWindows = QVector<MineWindow>();
+    forwardWindows = QVector<MineWindow>();
+
+    pathsBack = PathCounts();
+    pathsForward = PathCounts();
+
+    releaseStateLookup();
+
+    // the arena's share stays counted until the arena is cleared, which for a checkpoint is only once the whole graph is done with
+    holdBytes(-(heldBytes.loadRelaxed() - arenaBytes.loadRelaxed()));
+}
+
+void ChoiceColumn::releaseArenaBytes()
+{
+    holdBytes(-arenaBytes.loadRelaxed());
+
+    arenaBytes.storeRelaxed(0);
+}
+
+void ChoiceColumn::releaseForwardEdges()
+{
+    holdBytes(-(forwardEdgeOffsets.size() * qsizetype(sizeof(int)) + forwardEdges.size() * qsizetype(sizeof(ChoiceNode::Edge))));
+
+    forwardEdgeOffsets = QVector<int>();
+    forwardEdges = QVector<ChoiceNode::Edge>();
+}
+
+const QList<ChoiceNode*> &ChoiceColumn::getChoiceNodes() const
+{
+    return choiceNodes;
 }
 
 int ChoiceColumn::getX() const
@@ -52,29 +441,235 @@ int ChoiceColumn::getY() const
     return y;
 }
 
+const ColumnFringe &ChoiceColumn::getFringe() const
+{
+    return fringe;
+}
+
 void ChoiceColumn::setValidMinefieldCount(SolverFloat count)
 {
     validMinefieldCount = count;
 }
 
-QFuture<void> ChoiceColumn::precomputePathsForward(int mineCount)
+void ChoiceColumn::setTailPathCellCount(int count)
 {
-    // map seems to hate lambdas
-    return QtConcurrent::map(&(*columnCalcThreadPool), choicesInColumn, std::bind(&precomputePathsForwardForNode, std::placeholders::_1, mineCount));
+    tailPathCellCount = count;
+}
+
+void ChoiceColumn::setBinomialTable(const SolverMath::BinomialTable *table)
+{
+    binomials = table;
+}
+
+void ChoiceColumn::setMaxMinesForward(int count)
+{
+    maxMinesForward = count;
+}
+
+void ChoiceColumn::setPathNumerics(PathNumerics numerics)
+{
+    pathNumerics = numerics == PathNumerics::Automatic? PathNumerics::ScaledDouble : numerics;
+
+    // only scaled doubles can run out of range, and they start over anyway
+    pathRangeExceeded.storeRelaxed(0);
+}
+
+PathNumerics ChoiceColumn::getPathNumerics() const
+{
+    return pathNumerics;
+}
+
+void ChoiceColumn::setCountAllMineTotals(bool countAll)
+{
+    countAllMineTotals = countAll;
 }
 
-QFuture<void> ChoiceColumn::precomputePathsBack(int mineCount)
+void ChoiceColumn::setCancellationToken(const CancellationToken *token)
 {
+    cancellationToken = token;
+}
+
+void ChoiceColumn::setMemoryBudget(MemoryBudget *budget)
+{
+    memoryBudget = budget;
+}
+
+bool ChoiceColumn::isCancelled() const
+{
+    return (cancellationToken && cancellationToken->isCancelled()) || (memoryBudget && memoryBudget->isExceeded());
+}
+
+void ChoiceColumn::holdBytes(qsizetype bytes)
+{
+    heldBytes.fetchAndAddRelaxed(bytes);
+
+    if(memoryBudget)
+    {
+        bytes >= 0? memoryBudget->allocate(bytes) : memoryBudget->release(-bytes);
+    }
+}
+
+void ChoiceColumn::holdArenaBytes(qsizetype bytes)
+{
+    arenaBytes.fetchAndAddRelaxed(bytes);
+
+    holdBytes(bytes);
+}
+
+void ChoiceColumn::holdLookupBytes(qsizetype bytes)
+{
+    lookupBytes.fetchAndAddRelaxed(bytes);
+
+    if(memoryBudget)
+    {
+        bytes >= 0? memoryBudget->allocate(bytes) : memoryBudget->release(-bytes);
+    }
+}
+
+void ChoiceColumn::setPathModulus(quint64 modulus)
+{
+    pathModulus = modulus;
+}
+
+QFuture<void> ChoiceColumn::precomputePathsForward(int mineCount, const ChoiceColumn *nextColumn)
+{
+    if(forwardEdgeOffsets.isEmpty())
+    {// the final column's tail path counts are shared by all the threads from here on
+        countTailPaths(mineCount);
+    }
+
+    // the windows are only counted the first time, later passes fill them in again at the same size
+    holdBytes((choiceNodes.size() - forwardWindows.size()) * qsizetype(sizeof(MineWindow)));
+
+    forwardWindows.fill(MineWindow(), choiceNodes.size());
+
+    for(int i = 0; i < choiceNodes.size(); ++i)
+    {
+        MineWindow reachable;
+
+        if(forwardEdgeOffsets.isEmpty() || forwardEdgeOffsets[i] == forwardEdgeOffsets[i + 1])
+        {
+            if(choiceNodes[i]->isEndpoint())
+            {// only the tail path is left, which can hold any number of mines up to its size
+                reachable = {0, std::min(tailPathCellCount, mineCount)};
+            }
+        }
+        else
+        {
+            for(int edge = forwardEdgeOffsets[i]; edge < forwardEdgeOffsets[i + 1]; ++edge)
+            {
+                const MineWindow &nextWindow = nextColumn->forwardWindows[forwardEdges[edge].nodeIndex];
+
+                if(nextWindow.max < nextWindow.min)
+                {
+                    continue;
+                }
+
+                if(reachable.max < reachable.min)
+                {
+                    reachable = {nextWindow.min + forwardEdges[edge].cost, nextWindow.max + forwardEdges[edge].cost};
+                }
+                else
+                {
+                    reachable.min = std::min(reachable.min, nextWindow.min + forwardEdges[edge].cost);
+                    reachable.max = std::max(reachable.max, nextWindow.max + forwardEdges[edge].cost);
+                }
+            }
+        }
+
+        // only the counts that add up to the mine count with some count of the paths back are ever used
+        // unless every total is counted, then they all are
+        const MineWindow &backWindow = backWindows[i];
+
+        if(backWindow.max >= backWindow.min)
+        {
+            forwardWindows[i] = countAllMineTotals? reachable : MineWindow{std::max(reachable.min, mineCount - backWindow.max), std::min(reachable.max, mineCount - backWindow.min)};
+        }
+    }
+
+    allocatePathCounts(forwardWindows, pathsForward);
+
+    if(pathNumerics == PathNumerics::Exact)
+    {
+        // map seems to hate lambdas
+        return QtConcurrent::map(&(*columnCalcThreadPool), choiceNodes, std::bind(&precomputePathsForwardForNode<quint64>, std::placeholders::_1, this, nextColumn, mineCount));
+    }
+    else if(pathNumerics == PathNumerics::BinFloat)
+    {
+        // map seems to hate lambdas
+        return QtConcurrent::map(&(*columnCalcThreadPool), choiceNodes, std::bind(&precomputePathsForwardForNode<SolverFloat>, std::placeholders::_1, this, nextColumn, mineCount));
+    }
+
     // map seems to hate lambdas
-    return QtConcurrent::map(&(*columnCalcThreadPool), choicesInColumn, std::bind(&precomputePathsBackForNode, std::placeholders::_1, mineCount));
+    return QtConcurrent::map(&(*columnCalcThreadPool), choiceNodes, std::bind(&precomputePathsForwardForNode<double>, std::placeholders::_1, this, nextColumn, mineCount));
 }
 
-QFuture<void> ChoiceColumn::calculateWaysToBeMine(int mineCount)
+QFuture<void> ChoiceColumn::calculateWaysToBeMine(int mineCount, const ChoiceColumn *nextColumn)
 {
     waysToBeMine = 0;
+    waysToBeMineResidue = 0;
+    waysToBeMineByMineCount.clear();
+
+    if(pathNumerics == PathNumerics::Exact)
+    {
+        // map seems to hate lambdas
+        return QtConcurrent::map(&(*columnCalcThreadPool), choiceNodes, std::bind(&calculateWaysToBeMineForNode<quint64>, std::placeholders::_1, this, nextColumn, mineCount));
+    }
+    else if(pathNumerics == PathNumerics::BinFloat)
+    {
+        // map seems to hate lambdas
+        return QtConcurrent::map(&(*columnCalcThreadPool), choiceNodes, std::bind(&calculateWaysToBeMineForNode<SolverFloat>, std::placeholders::_1, this, nextColumn, mineCount));
+    }
     
     // map seems to hate lambdas
-    return QtConcurrent::map(&(*columnCalcThreadPool), choicesInColumn, std::bind(&calculateWaysToBeMineForNode, std::placeholders::_1, this, mineCount));
+    return QtConcurrent::map(&(*columnCalcThreadPool), choiceNodes, std::bind(&calculateWaysToBeMineForNode<double>, std::placeholders::_1, this, nextColumn, mineCount));
+}
+
+SolverFloat ChoiceColumn::findPathsForward(int nodeIndex, int mineCount) const
+{
+    // rely on the assumption that the paths have already been precomputed, anything outside the window is known to be zero
+    const MineWindow &window = forwardWindows[nodeIndex];
+
+    if(mineCount < window.min || mineCount > window.max)
+    {
+        return 0;
+    }
+
+    if(pathNumerics == PathNumerics::BinFloat)
+    {
+        return pathsForward.values<SolverFloat>(nodeIndex)[mineCount - window.min];
+    }
+
+    return scaledToSolverFloat(pathsForward.values<double>(nodeIndex)[mineCount - window.min], pathsForward.exponents[nodeIndex]);
+}
+
+quint64 ChoiceColumn::findPathsForwardResidue(int nodeIndex, int mineCount) const
+{
+    const MineWindow &window = forwardWindows[nodeIndex];
+
+    if(mineCount < window.min || mineCount > window.max)
+    {
+        return 0;
+    }
+
+    return pathsForward.values<quint64>(nodeIndex)[mineCount - window.min];
+}
+
+SolverFloat ChoiceColumn::findPathsBack(int nodeIndex, int mineCount) const
+{
+    const MineWindow &window = backWindows[nodeIndex];
+
+    if(mineCount < window.min || mineCount > window.max)
+    {
+        return 0;
+    }
+
+    if(pathNumerics == PathNumerics::BinFloat)
+    {
+        return pathsBack.values<SolverFloat>(nodeIndex)[mineCount - window.min];
+    }
+
+    return scaledToSolverFloat(pathsBack.values<double>(nodeIndex)[mineCount - window.min], pathsBack.exponents[nodeIndex]);
 }
 
 double ChoiceColumn::getPercentChanceToBeMine() const
@@ -88,21 +683,582 @@ SolverFloat ChoiceColumn::getWaysToBeMine() const
     return waysToBeMine;
 }
 
-void ChoiceColumn::precomputePathsForwardForNode(const QSharedPointer<ChoiceNode> &choiceNode, int mineCount)
+const QVector<SolverFloat> &ChoiceColumn::getWaysToBeMineByMineCount() const
+{
+    return waysToBeMineByMineCount;
+}
+
+QVector<SolverFloat> ChoiceColumn::getPathsBackByMineCount(int nodeIndex) const
+{
+    const MineWindow &window = backWindows[nodeIndex];
+
+    QVector<SolverFloat> paths(std::max(0, window.max + 1), 0);
+
+    for(int i = window.min; i <= window.max; ++i)
+    {
+        paths[i] = findPathsBack(nodeIndex, i);
+    }
+
+    return paths;
+}
+
+quint64 ChoiceColumn::getWaysToBeMineResidue() const
+{
+    return waysToBeMineResidue;
+}
+
+bool ChoiceColumn::isPathRangeExceeded() const
+{
+    return pathRangeExceeded.loadRelaxed() != 0;
+}
+
+void ChoiceColumn::allocatePathCounts(const QVector<MineWindow> &windows, PathCounts &counts)
+{
+    QVector<qsizetype> offsets(windows.size() + 1);
+    offsets[0] = 0;
+
+    for(int i = 0; i < windows.size(); ++i)
+    {
+        offsets[i + 1] = offsets[i] + windowSize(windows[i].min, windows[i].max);
+    }
+
+    if(counts.exponents && counts.numerics == pathNumerics && counts.offsets == offsets)
+    {// the counts are redone with the same windows for every prime, so the last pass's arrays are cleared and used again instead of taking more of the arena
+        std::fill(counts.exponents, counts.exponents + windows.size(), NO_PATHS_EXPONENT);
+
+        if(pathNumerics == PathNumerics::Exact)
+        {
+            std::fill(counts.residues, counts.residues + offsets.last(), 0);
+        }
+        else if(pathNumerics == PathNumerics::BinFloat)
+        {
+            counts.wide.fill(SolverFloat(0));
+        }
+        else
+        {
+            std::fill(counts.scaled, counts.scaled + offsets.last(), 0.0);
+        }
+
+        return;
+    }
+
+    // the arena keeps every allocation until the graph is freed, so only the vectors give anything back when the counts are redone
+    holdBytes((offsets.size() - counts.offsets.size()) * qsizetype(sizeof(qsizetype)) - counts.wide.size() * qsizetype(sizeof(SolverFloat)));
+
+    counts.offsets = offsets;
+    counts.numerics = pathNumerics;
+
+    // the arena isn't thread safe, so this happens before the work is handed to the pool
+    counts.exponents = arena->createArray<int>(windows.size());
+    std::fill(counts.exponents, counts.exponents + windows.size(), NO_PATHS_EXPONENT);
+
+    counts.scaled = nullptr;
+    counts.wide = QVector<SolverFloat>();
+    counts.residues = nullptr;
+
+    holdArenaBytes(windows.size() * sizeof(int));
+
+    if(pathNumerics == PathNumerics::Exact)
+    {
+        counts.residues = arena->createArray<quint64>(offsets.last());
+
+        holdArenaBytes(offsets.last() * sizeof(quint64));
+    }
+    else if(pathNumerics == PathNumerics::BinFloat)
+    {// SolverFloats aren't promised to be trivially destructible, so they can't go in the arena
+        counts.wide = QVector<SolverFloat>(offsets.last(), SolverFloat(0));
+
+        holdBytes(offsets.last() * sizeof(SolverFloat));
+    }
+    else
+    {
+        counts.scaled = arena->createArray<double>(offsets.last());
+
+        holdArenaBytes(offsets.last() * sizeof(double));
+    }
+}
+
+void ChoiceColumn::normalizePaths(double *paths, int count, int &exponent)
+{
+    double largest = 0;
+    double smallestNonZero = 0;
+
+    PathKernels::range(paths, count, largest, smallestNonZero);
+
+    if(largest == 0)
+    {
+        exponent = NO_PATHS_EXPONENT;
+        return;
+    }
+
+    int largestExponent = 0;
+    int smallestExponent = 0;
+
+    std::frexp(largest, &largestExponent);
+    std::frexp(smallestNonZero, &smallestExponent);
+
+    if(largestExponent - smallestExponent > PATH_RANGE_LIMIT)
+    {
+        pathRangeExceeded.storeRelaxed(1);
+    }
+
+    // scaling by a power of two is exact, so this only moves the magnitude from the doubles into the exponent
+    PathKernels::scale(paths, count, std::ldexp(1.0, -largestExponent));
+    exponent += largestExponent;
+}
+
+void ChoiceColumn::normalizePaths(SolverFloat *paths, int count, int &exponent)
+{
+    exponent = std::any_of(paths, paths + count, [](const SolverFloat &path) { return path != 0; })? 0 : NO_PATHS_EXPONENT;
+}
+
+void ChoiceColumn::countTailPaths(int mineCount)
+{
+    tailPaths = TailPathCounts();
+
+    // the tail path is filled in any way the mines fit, which can be far larger than a double
+    // with no tail path cells the only way is to place no mines at all
+    for(int i = 0; i <= std::min(tailPathCellCount, mineCount); ++i)
+    {
+        if(pathNumerics == PathNumerics::Exact)
+        {
+            tailPaths.pathResidues.append(SolverMath::chooseModulo(tailPathCellCount, i, pathModulus));
+            tailPaths.mineResidues.append(SolverMath::chooseModulo(tailPathCellCount - 1, i - 1, pathModulus));
+        }
+        else
+        {
+            tailPaths.paths.append(binomials->choose(tailPathCellCount, i));
+            tailPaths.mines.append(binomials->choose(tailPathCellCount - 1, i - 1));
+        }
+    }
+}
+
+void ChoiceColumn::storeTailPaths(double *paths, const MineWindow &window, int &exponent)
+{
+    QVector<SolverFloat> counts = tailPaths.paths.mid(window.min, windowSize(window.min, window.max));
+
+    // the counts can be far larger than a double, so they're scaled down before they're converted
+    SolverFloat largest = 0;
+
+    for(const SolverFloat &count : counts)
+    {
+        largest = std::max(largest, count);
+    }
+
+    if(largest == 0)
+    {
+        exponent = NO_PATHS_EXPONENT;
+        return;
+    }
+
+    boost::multiprecision::frexp(largest, &exponent);
+
+    for(int i = 0; i < counts.size(); ++i)
+    {
+        paths[i] = boost::multiprecision::ldexp(counts[i], -exponent).convert_to<double>();
+    }
+
+    normalizePaths(paths, counts.size(), exponent);
+}
+
+void ChoiceColumn::storeTailPaths(SolverFloat *paths, const MineWindow &window, int &exponent)
+{
+    int count = windowSize(window.min, window.max);
+
+    std::copy(tailPaths.paths.constBegin() + window.min, tailPaths.paths.constBegin() + window.min + count, paths);
+
+    normalizePaths(paths, count, exponent);
+}
+
+void ChoiceColumn::storeTailPaths(quint64 *paths, const MineWindow &window, int &exponent)
+{
+    int count = windowSize(window.min, window.max);
+
+    std::copy(tailPaths.pathResidues.constBegin() + window.min, tailPaths.pathResidues.constBegin() + window.min + count, paths);
+
+    normalizePaths(paths, count, exponent);
+}
+
+void ChoiceColumn::normalizePaths(quint64 *paths, int count, int &exponent)
+{
+    Q_UNUSED(paths);
+    Q_UNUSED(count);
+
+    // a residue of zero doesn't mean there are no paths, so the exponent can only say that some were counted
+    exponent = 0;
+}
+
+void ChoiceColumn::addScaledPaths(double *target, const double *source, int count, double scale) const
+{
+    PathKernels::scaledAdd(target, source, count, scale);
+}
+
+void ChoiceColumn::addScaledPaths(SolverFloat *target, const SolverFloat *source, int count, double scale) const
+{
+    // the exponents of SolverFloat counts are all the same, so they never need scaling
+    Q_UNUSED(scale);
+
+    for(int i = 0; i < count; ++i)
+    {
+        target[i] += source[i];
+    }
+}
+
+void ChoiceColumn::addScaledPaths(quint64 *target, const quint64 *source, int count, double scale) const
+{
+    // the same goes for residues
+    Q_UNUSED(scale);
+
+    PathKernels::addModulo(target, source, count, pathModulus);
+}
+
+void ChoiceColumn::scalePaths(double *paths, int count, double factor) const
 {
-    choiceNode->precomputePathsForward(mineCount);
+    PathKernels::scale(paths, count, factor);
 }
 
-void ChoiceColumn::precomputePathsBackForNode(const QSharedPointer<ChoiceNode> &choiceNode, int mineCount)
+void ChoiceColumn::scalePaths(SolverFloat *paths, int count, double factor) const
 {
-    choiceNode->precomputePathsBack(mineCount);
+    for(int i = 0; i < count; ++i)
+    {
+        paths[i] *= SolverFloat(factor);
+    }
+}
+
+void ChoiceColumn::scalePaths(quint64 *paths, int count, double factor) const
+{
+    // residues all have the same exponent, so there's never a factor other than 1
+    Q_UNUSED(paths);
+    Q_UNUSED(count);
+    Q_UNUSED(factor);
+}
+
+double ChoiceColumn::pairPaths(const double *pathsBack, const double *pathsForward, int count) const
+{
+    return PathKernels::reversedDot(pathsBack, pathsForward, count);
+}
+
+SolverFloat ChoiceColumn::pairPaths(const SolverFloat *pathsBack, const SolverFloat *pathsForward, int count) const
+{
+    SolverFloat sum = 0;
+
+    for(int i = 0; i < count; ++i)
+    {
+        sum += pathsBack[i] * pathsForward[count - 1 - i];
+    }
+
+    return sum;
+}
+
+quint64 ChoiceColumn::pairPaths(const quint64 *pathsBack, const quint64 *pathsForward, int count) const
+{
+    return PathKernels::reversedDotModulo(pathsBack, pathsForward, count, pathModulus);
+}
+
+double ChoiceColumn::exponentScale(int exponentDifference)
+{
+    if(exponentDifference < -PATH_RANGE_LIMIT)
+    {
+        pathRangeExceeded.storeRelaxed(1);
+    }
+
+    return std::ldexp(1.0, exponentDifference);
+}
+
+int ChoiceColumn::stateShard(const ColumnFringe::FringeState &fringeState) const
+{
+    // the zobrist hash is already random, dense indices of neighbouring states spread across shards
+    return fringe.isDense()? fringeState.index % STATE_SHARD_COUNT : fringeState.hash % STATE_SHARD_COUNT;
+}
+
+void ChoiceColumn::generateSuccessorsForNode(ChoiceNode *choiceNode, ChoiceColumn *column, ChoiceColumn *nextColumn, ChoiceNode **successors, int mineCount)
+{
+    if(column->isCancelled())
+    {
+        return;
+    }
+
+    const MineWindow &backWindow = column->backWindows[choiceNode->getIndex()];
+
+    if(backWindow.max < backWindow.min || (!column->countAllMineTotals && backWindow.max + column->maxMinesForward < mineCount))
+    {// even placing a mine in every cell left can't reach the mine count, so nothing after this node can be part of a solution
+        return;
+    }
+
+    choiceNode->addSuccessorsToNextColumn(column->fringe, *nextColumn, successors + 2 * choiceNode->getIndex());
+}
+
+template<typename T>
+void ChoiceColumn::precomputePathsForwardForNode(ChoiceNode *choiceNode, ChoiceColumn *column, const ChoiceColumn *nextColumn, int mineCount)
+{
+    Q_UNUSED(mineCount);
+
+    if(column->isCancelled())
+    {
+        return;
+    }
+
+    int nodeIndex = choiceNode->getIndex();
+    const MineWindow &window = column->forwardWindows[nodeIndex];
+    T *paths = column->pathsForward.values<T>(nodeIndex);
+    int &exponent = column->pathsForward.exponents[nodeIndex];
+
+    int count = windowSize(window.min, window.max);
+
+    if(column->forwardEdgeOffsets.isEmpty() || column->forwardEdgeOffsets[nodeIndex] == column->forwardEdgeOffsets[nodeIndex + 1])
+    {// no more edges to proceed through, only report paths if we've reached an endpoint
+        if(!choiceNode->isEndpoint() || count == 0)
+        {
+            return;
+        }
+
+        column->storeTailPaths(paths, window, exponent);
+
+        return;
+    }
+
+    // the counts of every successor are brought to the largest exponent among them before they're added
+    for(int i = column->forwardEdgeOffsets[nodeIndex]; i < column->forwardEdgeOffsets[nodeIndex + 1]; ++i)
+    {
+        exponent = std::max(exponent, nextColumn->pathsForward.exponents[column->forwardEdges[i].nodeIndex]);
+    }
+
+    if(exponent == NO_PATHS_EXPONENT)
+    {
+        return;
+    }
+
+    for(int i = column->forwardEdgeOffsets[nodeIndex]; i < column->forwardEdgeOffsets[nodeIndex + 1]; ++i)
+    {
+        const ChoiceNode::Edge &edge = column->forwardEdges[i];
+        const MineWindow &nextWindow = nextColumn->forwardWindows[edge.nodeIndex];
+        int nextExponent = nextColumn->pathsForward.exponents[edge.nodeIndex];
+
+        // the paths forward through the edge using some count of mines are the next node's paths using that many less the edge's cost
+        int low = std::max(window.min, nextWindow.min + edge.cost);
+        int high = std::min(window.max, nextWindow.max + edge.cost);
+
+        if(nextExponent == NO_PATHS_EXPONENT || low > high)
+        {
+            continue;
+        }
+
+        const T *nextPaths = nextColumn->pathsForward.values<T>(edge.nodeIndex);
+
+        column->addScaledPaths(paths + low - window.min, nextPaths + low - edge.cost - nextWindow.min, high - low + 1, column->exponentScale(nextExponent - exponent));
+    }
+
+    column->normalizePaths(paths, count, exponent);
+}
+
+template<typename T>
+void ChoiceColumn::pushPathsBackForPartition(int partition, ChoiceColumn *column, ChoiceColumn *nextColumn, int mineCount)
+{
+    // each target gathers its incoming paths in source order, so the sums come out the same every time
+    for(int target = partition; target < nextColumn->choiceNodes.size(); target += STATE_SHARD_COUNT)
+    {
+        // a partition can have a lot of targets, so it checks in every so often rather than only at the start
+        if(target % (256 * STATE_SHARD_COUNT) == partition && column->isCancelled())
+        {
+            return;
+        }
+
+        const MineWindow &targetWindow = nextColumn->backWindows[target];
+        T *targetPaths = nextColumn->pathsBack.values<T>(target);
+        int &targetExponent = nextColumn->pathsBack.exponents[target];
+
+        for(int i = nextColumn->incomingEdgeOffsets[target]; i < nextColumn->incomingEdgeOffsets[target + 1]; ++i)
+        {
+            const ChoiceNode::Edge &edge = nextColumn->incomingEdges[i];
+
+            const MineWindow &sourceWindow = column->backWindows[edge.nodeIndex];
+            const T *sourcePaths = column->pathsBack.values<T>(edge.nodeIndex);
+            int sourceExponent = column->pathsBack.exponents[edge.nodeIndex];
+
+            // every path back to the source is a path back to the target with the edge's cost added
+            int high = std::min(sourceWindow.max, mineCount - edge.cost);
+
+            if(sourceExponent == NO_PATHS_EXPONENT || sourceWindow.min > high)
+            {
+                continue;
+            }
+
+            if(targetExponent == NO_PATHS_EXPONENT)
+            {
+                targetExponent = sourceExponent;
+            }
+            else if(sourceExponent > targetExponent)
+            {// the target's counts so far are brought to the larger exponent so the new counts can't overflow it
+                nextColumn->scalePaths(targetPaths, windowSize(targetWindow.min, targetWindow.max), nextColumn->exponentScale(targetExponent - sourceExponent));
+                targetExponent = sourceExponent;
+            }
+
+            nextColumn->addScaledPaths(targetPaths + sourceWindow.min + edge.cost - targetWindow.min, sourcePaths, high - sourceWindow.min + 1, nextColumn->exponentScale(sourceExponent - targetExponent));
+        }
+
+        if(targetExponent != NO_PATHS_EXPONENT)
+        {
+            nextColumn->normalizePaths(targetPaths, windowSize(targetWindow.min, targetWindow.max), targetExponent);
+        }
+    }
 }
 
-void ChoiceColumn::calculateWaysToBeMineForNode(const QSharedPointer<ChoiceNode> &choiceNode, ChoiceColumn *column, int mineCount)
+template<typename T>
+void ChoiceColumn::calculateWaysToBeMineForNode(ChoiceNode *choiceNode, ChoiceColumn *column, const ChoiceColumn *nextColumn, int mineCount)
 {
-    choiceNode->calculateWaysToBeMine(mineCount);
+    if(column->isCancelled())
+    {
+        return;
+    }
+
+    int nodeIndex = choiceNode->getIndex();
+
+    // the edge with a cost is the one for this column's cell being a mine
+    int mineSuccessorIndex = -1;
+
+    if(!column->forwardEdgeOffsets.isEmpty())
+    {
+        for(int i = column->forwardEdgeOffsets[nodeIndex]; i < column->forwardEdgeOffsets[nodeIndex + 1]; ++i)
+        {
+            if(column->forwardEdges[i].cost > 0)
+            {
+                mineSuccessorIndex = column->forwardEdges[i].nodeIndex;
+            }
+        }
+    }
+
+    // we count paths in the graph with a fixed total cost to see how many ways this choice could be a mine in valid configurations of the minefield
+    SolverFloat waysToBeMine = 0;
+
+    // the mineCount input is how many total mines will distribute throughout the graph
+    // since we have to distribute them before and after this choice, so we need to loop across all possible distributions
+    // only the distributions with paths back can add anything
+    const MineWindow &backWindow = column->backWindows[nodeIndex];
+
+    if(column->tailPathCellCount > 0)
+    {// having a non-zero value for tail path cells is only possible for the trailing endpoint
+        // the paths forward for mine or clear are found with the choose function
+        // because there's no information on how they're distributed
+        // if we're a mine we choose i - 1 from the remaining tail path cells (we are one of them)
+        // these were counted for every i before the threads started, anything past the tail's size can't happen
+        for(int i = mineCount - backWindow.max; i <= mineCount - backWindow.min; ++i)
+        {
+            // these paths combine multiplicatively
+            waysToBeMine += column->findPathsBack(nodeIndex, mineCount - i) * column->tailPaths.mines.value(i);
+        }
+    }
+    else if(mineSuccessorIndex >= 0 && column->countAllMineTotals)
+    {// the same pairing as below, done for every total the paths can add up to
+        const MineWindow &forwardWindow = nextColumn->forwardWindows[mineSuccessorIndex];
+
+        if(backWindow.max >= backWindow.min && forwardWindow.max >= forwardWindow.min)
+        {
+            QVector<SolverFloat> waysByTotal(backWindow.max + forwardWindow.max + 2, 0);
+
+            for(int total = backWindow.min + forwardWindow.min + 1; total < waysByTotal.size(); ++total)
+            {
+                int low = std::max(backWindow.min, total - 1 - forwardWindow.max);
+                int high = std::min(backWindow.max, total - 1 - forwardWindow.min);
+
+                const T *backPaths = column->pathsBack.values<T>(nodeIndex) + low - backWindow.min;
+                const T *forwardPaths = nextColumn->pathsForward.values<T>(mineSuccessorIndex) + total - 1 - high - forwardWindow.min;
+
+                T sum = column->pairPaths(backPaths, forwardPaths, high - low + 1);
+
+                waysByTotal[total] = scaledToSolverFloat(sum, column->pathsBack.exponents[nodeIndex] + nextColumn->pathsForward.exponents[mineSuccessorIndex]);
+            }
+
+            QMutexLocker locker(&column->waysToBeMutex);
+
+            if(column->waysToBeMineByMineCount.size() < waysByTotal.size())
+            {
+                column->waysToBeMineByMineCount.resize(waysByTotal.size());
+            }
+
+            for(int total = 0; total < waysByTotal.size(); ++total)
+            {
+                column->waysToBeMineByMineCount[total] += waysByTotal[total];
+            }
+        }
+    }
+    else if(mineSuccessorIndex >= 0)
+    {// the paths back using some count of mines pair with the mine successor's paths forward using the rest but one
+        const MineWindow &forwardWindow = nextColumn->forwardWindows[mineSuccessorIndex];
+
+        int low = std::max(backWindow.min, mineCount - 1 - forwardWindow.max);
+        int high = std::min(backWindow.max, mineCount - 1 - forwardWindow.min);
+
+        if(low <= high)
+        {
+            const T *backPaths = column->pathsBack.values<T>(nodeIndex) + low - backWindow.min;
+            const T *forwardPaths = nextColumn->pathsForward.values<T>(mineSuccessorIndex) + mineCount - 1 - high - forwardWindow.min;
+
+            // these paths combine multiplicatively
+            T sum = column->pairPaths(backPaths, forwardPaths, high - low + 1);
+
+            waysToBeMine = scaledToSolverFloat(sum, column->pathsBack.exponents[nodeIndex] + nextColumn->pathsForward.exponents[mineSuccessorIndex]);
+        }
+    }
+
+    choiceNode->setWaysToBeMine(waysToBeMine);
+
+    QMutexLocker locker(&column->waysToBeMutex);
+
+    column->waysToBeMine += waysToBeMine;
+}
+
+template<>
+void ChoiceColumn::calculateWaysToBeMineForNode<quint64>(ChoiceNode *choiceNode, ChoiceColumn *column, const ChoiceColumn *nextColumn, int mineCount)
+{
+    if(column->isCancelled())
+    {
+        return;
+    }
+
+    int nodeIndex = choiceNode->getIndex();
+    quint64 modulus = column->pathModulus;
+
+    // the same pairing as for the other counts, only modulo the column's prime
+    const MineWindow &backWindow = column->backWindows[nodeIndex];
+    const quint64 *backPaths = column->pathsBack.values<quint64>(nodeIndex);
+
+    quint64 waysToBeMine = 0;
+
+    if(column->tailPathCellCount > 0)
+    {// the trailing endpoint is a mine in i - 1 of the ways to put i mines in the tail path cells, as it's one of them
+        for(int i = mineCount - backWindow.max; i <= mineCount - backWindow.min; ++i)
+        {
+            quint64 tailWays = column->tailPaths.mineResidues.value(i);
+
+            waysToBeMine = SolverMath::addModulo(waysToBeMine, SolverMath::multiplyModulo(backPaths[mineCount - i - backWindow.min], tailWays, modulus), modulus);
+        }
+    }
+    else if(!column->forwardEdgeOffsets.isEmpty())
+    {
+        for(int i = column->forwardEdgeOffsets[nodeIndex]; i < column->forwardEdgeOffsets[nodeIndex + 1]; ++i)
+        {
+            const ChoiceNode::Edge &edge = column->forwardEdges[i];
+
+            if(edge.cost == 0)
+            {
+                continue;
+            }
+
+            const MineWindow &forwardWindow = nextColumn->forwardWindows[edge.nodeIndex];
+
+            int low = std::max(backWindow.min, mineCount - 1 - forwardWindow.max);
+            int high = std::min(backWindow.max, mineCount - 1 - forwardWindow.min);
+
+            if(low <= high)
+            {
+                const quint64 *forwardPaths = nextColumn->pathsForward.values<quint64>(edge.nodeIndex) + mineCount - 1 - high - forwardWindow.min;
+
+                waysToBeMine = column->pairPaths(backPaths + low - backWindow.min, forwardPaths, high - low + 1);
+            }
+        }
+    }
 
     QMutexLocker locker(&column->waysToBeMutex);
 
-    column->waysToBeMine += choiceNode->getWaysToBeMine();
+    column->waysToBeMineResidue = SolverMath::addModulo(column->waysToBeMineResidue, waysToBeMine, modulus);
 }
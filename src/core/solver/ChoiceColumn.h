@@ -1,55 +1,304 @@
 #ifndef CHOICECOLUMN_H
 #define CHOICECOLUMN_H
 
+#include "CancellationToken.h"
+#include "ChoiceNode.h"
+#include "ColumnFringe.h"
+#include "MemoryBudget.h"
+#include "PathNumerics.h"
 #include "SolverFloat.h"
+#include "SolverMath.h"
 
-#include <QByteArray>
+#include <QAtomicInt>
 #include <QFuture>
-#include <QHash>
+#include <QList>
+#include <QMultiHash>
 #include <QMutex>
 #include <QSharedPointer>
+#include <QVector>
 
-class ChoiceNode;
-class SolverMinefield;
+class SolverArena;
 
 class ChoiceColumn
 {
 public:
-    ChoiceColumn(int x, int y);
+    // the states of a column being built are split into shards by their key, each with its own lock and arena shard
+    // the arena passed in needs at least this many shards
+    static const int STATE_SHARD_COUNT = 64;
 
-    QSharedPointer<ChoiceNode> getOrCreateChoiceNode(const SolverMinefield& minefield);
-    void addChoiceNode(QSharedPointer<ChoiceNode> node);
+    // the nodes of the column are allocated from the arena and are freed with it
+    ChoiceColumn(int x, int y, const ColumnFringe& fringe, SolverArena* arena);
+    // gives back whatever the column counted against the memory budget
+    ~ChoiceColumn();
 
-    QList<QSharedPointer<ChoiceNode>> getChoiceNodes() const;
+    // finds the node for the successor of a state in the previous column, creating it if the state is new
+    // the successor state only needs its key filled in, the rest is only built if a node has to be created
+    // this is safe to call from several threads at once, the node is given the discovery order if it's the earliest yet
+    ChoiceNode *getOrCreateChoiceNode(const ColumnFringe& previousFringe, const ColumnFringe::FringeState& previousState, bool mine, ColumnFringe::FringeState& fringeState, qint64 discoveryOrder);
+    // adds a node outside of a parallel build, used for the starting node
+    ChoiceNode *createChoiceNode(const ColumnFringe::FringeState& fringeState);
+    // the starting node is the only path back from itself, using no mines
+    void initializeStartingPathsBack(int mineCount);
+
+    // generates the successors of every node in this column across the thread pool
+    // nodes whose paths back can't be completed to the mine count are dead ends and get no successors
+    // once it finishes, linkSuccessors has to be called to number the next column's nodes and build the edges between the columns
+    QFuture<void> generateSuccessors(ChoiceColumn& nextColumn, int mineCount);
+    // this column gets the forward edges and the next column gets its nodes
+    // the paths back of this column are then pushed along the new edges, which completes the next column's paths back
+    // so the paths back are done by the time the graph is, the returned future finishes the push
+    QFuture<void> linkSuccessors(ChoiceColumn& nextColumn, int mineCount);
+    // pushes the paths back of this column along its edges into the next column, replacing whatever counts the next column had
+    // linkSuccessors already does this, it only needs calling again when the counts are redone
+    QFuture<void> pushPathsBack(ChoiceColumn& nextColumn, int mineCount);
+
+    // once the column is built, no more nodes are looked up by state, so the lookup's memory can be freed
+    void releaseStateLookup();
+    // drops the nodes, edges and path counts so the column can be built again, the ways to be a mine found from them are kept
+    // the nodes themselves are only freed with the arena, so their bytes stay counted against the budget until releaseArenaBytes
+    void releaseNodes();
+    // the column's arena was cleared, so what the column had in it goes back to the budget
+    void releaseArenaBytes();
+    // the edges are generated again whenever the next column is built again, so a column kept for its nodes can drop them in between
+    void releaseForwardEdges();
+
+    const QList<ChoiceNode*> &getChoiceNodes() const;
 
     int getX() const;
     int getY() const;
 
-    QFuture<void> precomputePathsForward(int mineCount);
-    QFuture<void> precomputePathsBack(int mineCount);
+    const ColumnFringe &getFringe() const;
+
+    // the only node of the final column stands in for the tail path cells
+    void setTailPathCellCount(int count);
+    // the tail path is counted with the solve's table, which has to cover the tail path cells and outlive the column
+    void setBinomialTable(const SolverMath::BinomialTable* table);
+    // the most mines that can be placed from this column on, which is the cells left in the path including this one plus the tail path
+    void setMaxMinesForward(int count);
+
+    // automatic stores scaled doubles, the counts already computed are lost so they have to be redone after changing it
+    // every column of a graph has to use the same numerics
+    void setPathNumerics(PathNumerics numerics);
+    PathNumerics getPathNumerics() const;
+    // exact counts are only kept modulo this prime, which has to be below 2^62, and larger than the number of path cells
+    void setPathModulus(quint64 modulus);
+
+    // a region solved on its own counts its paths for every total of mines instead of only the mine count
+    // nothing is pruned for missing the mine count, the paths forward aren't limited by it, and the ways to be a mine are kept for each total
+    // this has to be set before the graph is built, and doesn't work with exact numerics
+    void setCountAllMineTotals(bool countAll);
 
-    QFuture<void> calculateWaysToBeMine(int mineCount);
+    // the work on each node gives up once the token is cancelled, leaving the counts unfinished
+    // the token has to outlive the column
+    void setCancellationToken(const CancellationToken* token);
+    // the nodes, edges, lookups and path counts of the column are counted against the budget as they're made
+    // the work gives up like it was cancelled once the budget is exceeded, the budget has to outlive the column
+    void setMemoryBudget(MemoryBudget* budget);
+
+    // the next column needs to have its path counts computed already, the last column has none
+    QFuture<void> precomputePathsForward(int mineCount, const ChoiceColumn* nextColumn);
+
+    QFuture<void> calculateWaysToBeMine(int mineCount, const ChoiceColumn* nextColumn);
+
+    SolverFloat findPathsForward(int nodeIndex, int mineCount) const;
+    // the exact counts modulo the column's prime
+    quint64 findPathsForwardResidue(int nodeIndex, int mineCount) const;
 
     double getPercentChanceToBeMine() const;
     SolverFloat getWaysToBeMine() const;
+    quint64 getWaysToBeMineResidue() const;
     SolverFloat getWaysToBeClear() const;
+    // when counting all totals, entry i is the ways to be a mine among the paths that place i mines in all
+    const QVector<SolverFloat> &getWaysToBeMineByMineCount() const;
+    // the paths back of a node for every count of mines, entry i uses i mines
+    QVector<SolverFloat> getPathsBackByMineCount(int nodeIndex) const;
     
     void setValidMinefieldCount(SolverFloat count);
 
+    // set if some node's scaled double counts spread over more orders of magnitude than a double can keep track of
+    // the small counts of such a node may have been lost, so the results can't be trusted until they're redone with SolverFloats
+    bool isPathRangeExceeded() const;
+
 private:
-    static void precomputePathsForwardForNode(const QSharedPointer<ChoiceNode>& choiceNode, int mineCount);
-    static void precomputePathsBackForNode(const QSharedPointer<ChoiceNode>& choiceNode, int mineCount);
-    static void calculateWaysToBeMineForNode(const QSharedPointer<ChoiceNode>& choiceNode, ChoiceColumn* column, int mineCount);
+    static void generateSuccessorsForNode(ChoiceNode* choiceNode, ChoiceColumn* column, ChoiceColumn* nextColumn, ChoiceNode** successors, int mineCount);
+
+    // the path counting is written once for every kind of count, T is double for scaled doubles, SolverFloat, or quint64 for exact residues
+    template<typename T>
+    static void precomputePathsForwardForNode(ChoiceNode* choiceNode, ChoiceColumn* column, const ChoiceColumn* nextColumn, int mineCount);
+    template<typename T>
+    static void pushPathsBackForPartition(int partition, ChoiceColumn* column, ChoiceColumn* nextColumn, int mineCount);
+    template<typename T>
+    static void calculateWaysToBeMineForNode(ChoiceNode* choiceNode, ChoiceColumn* column, const ChoiceColumn* nextColumn, int mineCount);
+
+    SolverFloat findPathsBack(int nodeIndex, int mineCount) const;
+
+    bool isCancelled() const;
+
+    // groups the previous column's edges by their target in this column, which is what the push of the paths back walks
+    void gatherIncomingEdges(const ChoiceColumn& previousColumn);
+    void releaseIncomingEdges();
+
+    // counts the bytes against the budget, negative bytes give them back
+    void holdBytes(qsizetype bytes);
+    void holdArenaBytes(qsizetype bytes);
+    void holdLookupBytes(qsizetype bytes);
+
+    // the range of mine counts a node's paths can use, it's empty when max is below min
+    struct MineWindow
+    {
+        int min = 0;
+        int max = -1;
+    };
+
+    // the path counts of every node of the column in one direction
+    struct PathCounts
+    {
+        // the counts of node i start at offsets[i], the entry for a mine count is at its distance from the bottom of the window
+        QVector<qsizetype> offsets;
+
+        // scaled doubles are plain doubles so the passes over them vectorize
+        // the doubles of a node all share a power of two exponent to keep them in range, a node's count is its double times two to the power of its exponent
+        double *scaled = nullptr;
+        // SolverFloats don't need scaling, their exponents are only used to mark the nodes with no paths
+        QVector<SolverFloat> wide;
+        // exact counts are residues modulo the column's prime, with the same exponents as SolverFloats
+        quint64 *residues = nullptr;
+
+        int *exponents = nullptr;
+        // what the arrays were allocated for, they're only used again for the same numerics and windows
+        PathNumerics numerics = PathNumerics::Automatic;
+
+        template<typename T>
+        T *values(int nodeIndex);
+        template<typename T>
+        const T *values(int nodeIndex) const;
+    };
+
+    // allocates the path counts of every node in the column as one contiguous block, with room for only the counts in each node's window
+    // the exponents start out as having no paths
+    void allocatePathCounts(const QVector<MineWindow>& windows, PathCounts& counts);
+
+    // rescales a node's counts so the largest is just under 1 and adjusts its exponent to match
+    void normalizePaths(double* paths, int count, int& exponent);
+    // SolverFloats and residues are left as they are, the exponent only records if there are any paths
+    void normalizePaths(SolverFloat* paths, int count, int& exponent);
+    void normalizePaths(quint64* paths, int count, int& exponent);
 
-    QHash<QByteArray, QSharedPointer<ChoiceNode>> choicesInColumn;
+    // the trailing endpoint's paths forward are the ways to fill the tail path with each count of mines
+    // these are counted once per pass, before any thread reads them, for every count of mines the tail can take
+    struct TailPathCounts
+    {
+        QVector<SolverFloat> paths;
+        // the ways where the cell standing in for the tail path is one of the mines
+        QVector<SolverFloat> mines;
+        // the same modulo the column's prime for exact counts
+        QVector<quint64> pathResidues;
+        QVector<quint64> mineResidues;
+    };
+
+    void countTailPaths(int mineCount);
+    void storeTailPaths(double* paths, const MineWindow& window, int& exponent);
+    void storeTailPaths(SolverFloat* paths, const MineWindow& window, int& exponent);
+    void storeTailPaths(quint64* paths, const MineWindow& window, int& exponent);
+
+    // the arithmetic on path counts for each kind of count, the double versions hand off to the vectorized kernels
+    // target[i] += source[i] * scale
+    void addScaledPaths(double* target, const double* source, int count, double scale) const;
+    void addScaledPaths(SolverFloat* target, const SolverFloat* source, int count, double scale) const;
+    void addScaledPaths(quint64* target, const quint64* source, int count, double scale) const;
+    // paths[i] *= factor
+    void scalePaths(double* paths, int count, double factor) const;
+    void scalePaths(SolverFloat* paths, int count, double factor) const;
+    void scalePaths(quint64* paths, int count, double factor) const;
+    // the sum of pathsBack[i] * pathsForward[count - 1 - i]
+    double pairPaths(const double* pathsBack, const double* pathsForward, int count) const;
+    SolverFloat pairPaths(const SolverFloat* pathsBack, const SolverFloat* pathsForward, int count) const;
+    quint64 pairPaths(const quint64* pathsBack, const quint64* pathsForward, int count) const;
+    // the factor that brings counts with one exponent to another, counts with very different exponents can't be added without losing the smaller
+    double exponentScale(int exponentDifference);
+
+    SolverArena *arena = nullptr;
+
+    QList<ChoiceNode*> choiceNodes;
+
+    // the edges of node i are in [forwardEdgeOffsets[i], forwardEdgeOffsets[i + 1]) of forwardEdges and point into the next column
+    // the offsets are empty for the final column
+    // there are no back edges, everything that walks the graph backward is pushed forward along these instead
+    QVector<int> forwardEdgeOffsets;
+    QVector<ChoiceNode::Edge> forwardEdges;
+    // while the paths back are pushed into this column, the previous column's edges are grouped by the node they lead to here
+    // the node index of each of these is the edge's source, so every edge is read once by the one thread that owns its target
+    QVector<int> incomingEdgeOffsets;
+    QVector<ChoiceNode::Edge> incomingEdges;
+
+    // a node deep in the path can only have used so many mines before it and can only place so many after it
+    // so each node only stores the path counts for the mine counts in its windows
+    // paths forward are also limited to the counts that can complete the paths back to exactly the mine count, since no others are ever read
+    QVector<MineWindow> backWindows;
+    QVector<MineWindow> forwardWindows;
+
+    PathCounts pathsForward;
+    PathCounts pathsBack;
+
+    PathNumerics pathNumerics = PathNumerics::ScaledDouble;
+    quint64 pathModulus = 0;
+
+    QAtomicInt pathRangeExceeded;
+
+    int tailPathCellCount = 0;
+    TailPathCounts tailPaths;
+    const SolverMath::BinomialTable *binomials = nullptr;
+    int maxMinesForward = 0;
+
+    // the successors found by generateSuccessors, two slots per node with the mine choice first
+    QVector<ChoiceNode*> successorSlots;
+
+    // the push of the paths back is split by target node so that no two threads add into the same node
+    // map needs a sequence to work over, this is just the partition numbers
+    QVector<int> pathPushPartitions;
+
+    struct StateShard
+    {
+        QMutex mutex;
+
+        // hashed fringes map the zobrist hash of a state to its nodes, dense fringes without an array map their index to their node
+        QMultiHash<quint64, ChoiceNode*> hashedStateLookup;
+    };
+
+    // a state's shard is picked from its key, so the same state always goes to the same shard
+    StateShard stateShards[STATE_SHARD_COUNT];
+
+    // dense fringes use an array over every possible state index instead of a hash, when the column is big enough to fill it
+    // the array is shared, but each entry is only touched while holding the lock of the entry's shard
+    // the threads go through the array's data so nothing they do can make the vector detach
+    QVector<ChoiceNode*> denseStateLookup;
+    ChoiceNode **denseStateSlots = nullptr;
+
+    int stateShard(const ColumnFringe::FringeState& fringeState) const;
 
     int x = 0;
     int y = 0;
 
+    ColumnFringe fringe;
+
     QMutex waysToBeMutex;
 
     SolverFloat waysToBeMine = 0;
     SolverFloat validMinefieldCount = 0;
+
+    quint64 waysToBeMineResidue = 0;
+
+    bool countAllMineTotals = false;
+    QVector<SolverFloat> waysToBeMineByMineCount;
+
+    const CancellationToken *cancellationToken = nullptr;
+
+    MemoryBudget *memoryBudget = nullptr;
+    // the bytes counted against the budget, the lookup's are kept apart since they're given back once the column is built
+    QAtomicInteger<qint64> heldBytes;
+    QAtomicInteger<qint64> lookupBytes;
+    // the part of the held bytes that's in the arena, which only the arena being cleared gives back
+    QAtomicInteger<qint64> arenaBytes;
 };
 
 #endif // CHOICECOLUMN_H
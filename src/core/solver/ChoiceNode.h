@@ -1,80 +1,61 @@
 #ifndef CHOICENODE_H
 #define CHOICENODE_H
 
-#include <QEnableSharedFromThis>
-
-#include <QHash>
-#include <QList>
-#include <QSharedPointer>
-
+#include "ColumnFringe.h"
 #include "SolverFloat.h"
-#include "SolverMinefield.h"
 
 class ChoiceColumn;
 
-// this class represents a node in the powerset DAG. It has a state and edges for the DAG and its reverse
-class ChoiceNode : public QEnableSharedFromThis<ChoiceNode>
+// this class represents a node in the powerset DAG. It has a state and its position in its column
+// the edges and path counts of the DAG are kept by the columns in flat arrays indexed by that position
+// nodes live in the solver's arena, so nothing here owns memory
+class ChoiceNode
 {
 public:
-    ChoiceNode(const SolverMinefield& minefield, int x, int y);
+    explicit ChoiceNode(const ColumnFringe::FringeState& fringeState);
 
     struct Edge
     {
-        // this needs to be a weak pointer because we store back edges and shared pointers with looping references equal memory leaks
-        QWeakPointer<ChoiceNode> nextNode;
+        // the index of the target node in the adjacent column, so edges are just two ints and never need to be dereferenced
+        int nodeIndex = -1;
         int cost = 0;
     };
 
-    const SolverMinefield &getMinefield() const;
-
-    const QList<Edge> &getEdgesForward() const;
-    const QList<Edge> &getEdgesBack() const;
+    // the counts of the column's fringe cells in this state
+    const ColumnFringe::FringeState &getFringeState() const;
 
-    // adds the successor choices (mine or clear) to the next column
-    void addSuccessorsToNextColumn(QSharedPointer<ChoiceColumn> nextColumn);
+    // the position of the node in its column, this is assigned once the column is complete
+    int getIndex() const;
+    void setIndex(int newIndex);
 
-    void precomputePathsForward(int mineCount);
-    void precomputePathsBack(int mineCount);
+    // while a column is being built its nodes are found from several threads, so the order they're created in isn't fixed
+    // each node remembers the earliest successor slot of the previous column that leads to it, which orders the column like a serial build would
+    qint64 getDiscoveryOrder() const;
+    void discover(qint64 order);
 
-    void calculateWaysToBeMine(int mineCount);
+    // adds the successor choices (mine or clear) to the next column
+    // the successors are written to the two slots given, mine first, with nullptr for an illegal choice
+    // this is safe to call for several nodes of a column at once
+    void addSuccessorsToNextColumn(const ColumnFringe& fringe, ChoiceColumn& nextColumn, ChoiceNode** successors) const;
 
     SolverFloat getWaysToBeMine() const;
+    void setWaysToBeMine(SolverFloat newWaysToBeMine);
 
     bool isEndpoint() const;
     void setEndpoint(bool newEndpoint);
 
-    void setTailPathCellCount(int count);
-
-    SolverFloat findPathsForward(int mineCount) const;
-
 private:
-    SolverMinefield minefield;
-
-    int x = -1;
-    int y = -1;
-
-    int tailPathCellCount = 0;
-    mutable QHash<int, SolverFloat> tailPathCounts;
+    ColumnFringe::FringeState fringeState;
 
-    QList<Edge> edgesForward;
-    QList<Edge> edgesBack;
+    int index = -1;
 
-    QWeakPointer<ChoiceNode> mineForwardEdge;
-
-    QList<SolverFloat> pathsForward;
-    QList<SolverFloat> pathsBack;
+    qint64 discoveryOrder = -1;
 
     SolverFloat waysToBeMine = 0;
 
     bool endpoint = false;
 
-    void tryAddEdge(QSharedPointer<ChoiceColumn> column, const SolverMinefield& minefield, int cost);
-    void linkTarget(QSharedPointer<ChoiceNode> edgeTarget, int cost);
-    
-    SolverFloat findPathsBack(int mineCount) const;
-    SolverFloat findPaths(int mineCount, bool forward) const;
-
-    void precomputePaths(int mineCount, bool forward);
+    ChoiceNode *findSuccessor(ChoiceColumn& column, const ColumnFringe& fringe, bool mine) const;
 };
 
 #endif // CHOICENODE_H
@@ -0,0 +1,348 @@
+#include "ColumnFringe.h"
+
+#include "SolverMinefield.h"
+
+#include <QHash>
+
+#include <algorithm>
+#include <random>
+
+
+// a count cell can have at most 8 adjacent unknowns, so its remaining count in a legal state is one of 9 values
+static const int ZOBRIST_COUNTS = 9;
+// the keys only need to be well distributed, a fixed seed keeps solves reproducible
+static const quint64 ZOBRIST_SEED = 0x5eed;
+
+QList<ColumnFringe> ColumnFringe::buildFringes(const SolverMinefield &startingMinefield, const CoordVector &path, qint64 maxDenseStateSpace)
+{
+    auto traverseAdjacentCountCells = [&] (const Coordinate& coord, std::function<void(const Coordinate&)> func) {
+        startingMinefield.traverseAdjacentCells(coord.first, coord.second, [&] (int x, int y) -> void {
+            if(startingMinefield.getCell(x, y) >= 0)
+            {
+                func({x, y});
+            }
+        });
+    };
+
+    // every unknown cell adjacent to a count cell is on the path, so the unvisited unknowns of a count cell are the path cells adjacent to it not yet chosen
+    QHash<Coordinate, int> remainingUnknowns;
+    QHash<Coordinate, int> totalUnknowns;
+    QHash<Coordinate, int> cellIds;
+
+    for(const Coordinate &coord : path)
+    {
+        traverseAdjacentCountCells(coord, [&] (const Coordinate& countCell) {
+            if(!cellIds.contains(countCell))
+            {
+                cellIds.insert(countCell, cellIds.size());
+            }
+
+            remainingUnknowns[countCell] += 1;
+            totalUnknowns[countCell] += 1;
+        });
+    }
+
+    // hashed states xor together a random key for each of their cells' counts, so changing one count only touches its two keys
+    QVector<quint64> zobristKeys(cellIds.size() * ZOBRIST_COUNTS);
+
+    std::mt19937_64 zobristGenerator(ZOBRIST_SEED);
+
+    for(quint64 &key : zobristKeys)
+    {
+        key = zobristGenerator();
+    }
+
+    QList<ColumnFringe> fringes;
+
+    // the first column has not been influenced by anything so its fringe is empty
+    QVector<FringeCell> currentCells;
+
+    for(const Coordinate &coord : path)
+    {
+        ColumnFringe fringe;
+        fringe.cells = currentCells;
+        fringe.zobristKeys = zobristKeys;
+
+        QHash<Coordinate, int> currentIndices;
+
+        for(int i = 0; i < currentCells.size(); ++i)
+        {
+            currentIndices.insert(currentCells[i].coord, i);
+        }
+
+        QList<Coordinate> adjacentCountCells;
+
+        traverseAdjacentCountCells(coord, [&] (const Coordinate& countCell) {
+            adjacentCountCells.append(countCell);
+
+            // choosing this column's cell visits one of the count cell's unknowns
+            remainingUnknowns[countCell] -= 1;
+        });
+
+        auto makeSlot = [&] (const Coordinate& countCell) {
+            SuccessorSlot slot;
+
+            slot.id = cellIds[countCell];
+            slot.sourceIndex = currentIndices.value(countCell, -1);
+            slot.startingCount = startingMinefield.getCell(countCell.first, countCell.second);
+            slot.adjacentToChoice = adjacentCountCells.contains(countCell);
+            slot.remainingUnknowns = remainingUnknowns[countCell];
+
+            return slot;
+        };
+
+        QVector<FringeCell> nextCells;
+
+        auto addToNextFringe = [&] (const Coordinate& countCell) {
+            FringeCell cell;
+
+            cell.id = cellIds[countCell];
+            cell.coord = countCell;
+            cell.startingCount = startingMinefield.getCell(countCell.first, countCell.second);
+            cell.remainingUnknowns = remainingUnknowns[countCell];
+
+            // the count can't exceed the unknowns left to fill it and can only have gone down by one for each visited unknown
+            int visitedUnknowns = totalUnknowns[countCell] - cell.remainingUnknowns;
+            cell.maxCount = std::min<int>(cell.startingCount, cell.remainingUnknowns);
+            cell.minCount = std::max<int>(0, cell.startingCount - visitedUnknowns);
+
+            SuccessorSlot slot = makeSlot(countCell);
+
+            if(slot.adjacentToChoice)
+            {
+                fringe.adjacentSlots.append(fringe.successorSlots.size());
+            }
+
+            nextCells.append(cell);
+            fringe.successorSlots.append(slot);
+        };
+
+        // cells already in the fringe keep their relative order, then the newly influenced cells are appended
+        for(const FringeCell &cell : currentCells)
+        {
+            if(remainingUnknowns[cell.coord] > 0)
+            {
+                addToNextFringe(cell.coord);
+            }
+        }
+
+        for(const Coordinate &countCell : adjacentCountCells)
+        {
+            if(remainingUnknowns[countCell] > 0 && !currentIndices.contains(countCell))
+            {
+                addToNextFringe(countCell);
+            }
+            else if(remainingUnknowns[countCell] == 0)
+            {// no unknowns left, the count cell leaves the fringe and its count has to be exactly satisfied
+                fringe.closedSlots.append(makeSlot(countCell));
+            }
+        }
+
+        fringes.append(fringe);
+
+        currentCells = nextCells;
+    }
+
+    // the final column has no choice, every count cell is closed by the time we reach it
+    ColumnFringe finalFringe;
+    finalFringe.cells = currentCells;
+
+    fringes.append(finalFringe);
+
+    for(ColumnFringe &fringe : fringes)
+    {
+        fringe.chooseEncoding(maxDenseStateSpace);
+    }
+
+    for(int i = 0; i < fringes.size() - 1; ++i)
+    {// the successor states are written in the encoding of the next column
+        fringes[i].linkSuccessorEncoding(fringes[i + 1]);
+    }
+
+    return fringes;
+}
+
+const QVector<ColumnFringe::FringeCell> &ColumnFringe::getCells() const
+{
+    return cells;
+}
+
+int ColumnFringe::size() const
+{
+    return cells.size();
+}
+
+bool ColumnFringe::isDense() const
+{
+    return dense;
+}
+
+qint64 ColumnFringe::getStateSpaceSize() const
+{
+    return stateSpaceSize;
+}
+
+ColumnFringe::FringeState ColumnFringe::emptyState() const
+{
+    // both encodings of a fringe without cells are all zero/empty
+    return FringeState();
+}
+
+MineStatus ColumnFringe::getCount(const FringeState &state, int cellIndex) const
+{
+    const FringeCell &cell = cells[cellIndex];
+
+    if(dense)
+    {
+        return cell.minCount + (state.index / cell.stride) % (cell.maxCount - cell.minCount + 1);
+    }
+
+    return state.counts[cellIndex];
+}
+
+bool ColumnFringe::chooseCellState(const FringeState &fringeState, bool mine, FringeState &successorState) const
+{
+    for(const SuccessorSlot &slot : closedSlots)
+    {
+        if(slotValue(slot, fringeState, mine) != 0)
+        {// every adjacent unknown is visited, the count had to be used up exactly
+            return false;
+        }
+    }
+
+    // cells that aren't adjacent to the choice keep their value and were already validated when they last changed
+    for(int slotIndex : adjacentSlots)
+    {
+        const SuccessorSlot &slot = successorSlots[slotIndex];
+
+        MineStatus value = slotValue(slot, fringeState, mine);
+
+        if(value < 0 || value > slot.remainingUnknowns)
+        {// this is a contradiction, it's not possible for there to be enough mines to satisfy the count
+            return false;
+        }
+    }
+
+    successorState.counts = nullptr;
+
+    if(successorDense)
+    {// the index is just the sum of each cell's offset in its range times its place value
+        successorState.index = 0;
+
+        for(const SuccessorSlot &slot : successorSlots)
+        {
+            successorState.index += (slotValue(slot, fringeState, mine) - slot.successorMinCount) * slot.successorStride;
+        }
+    }
+    else if(dense)
+    {// dense states don't carry a hash, so the successor's has to be built from all of its cells
+        successorState.hash = 0;
+
+        for(const SuccessorSlot &slot : successorSlots)
+        {
+            successorState.hash ^= zobristKey(slot.id, slotValue(slot, fringeState, mine));
+        }
+    }
+    else
+    {// only the cells adjacent to the choice change, so their old values are xored out of the hash and the new values xored in
+        successorState.hash = fringeState.hash;
+
+        for(const SuccessorSlot &slot : closedSlots)
+        {
+            if(slot.sourceIndex >= 0)
+            {// closed cells leave the fringe
+                successorState.hash ^= zobristKey(slot.id, fringeState.counts[slot.sourceIndex]);
+            }
+        }
+
+        for(int slotIndex : adjacentSlots)
+        {
+            const SuccessorSlot &slot = successorSlots[slotIndex];
+
+            if(slot.sourceIndex >= 0)
+            {
+                successorState.hash ^= zobristKey(slot.id, fringeState.counts[slot.sourceIndex]);
+            }
+
+            successorState.hash ^= zobristKey(slot.id, slotValue(slot, fringeState, mine));
+        }
+    }
+
+    return true;
+}
+
+bool ColumnFringe::successorMatches(const FringeState &fringeState, bool mine, const FringeState &candidateState) const
+{
+    for(int i = 0; i < successorSlots.size(); ++i)
+    {
+        if(slotValue(successorSlots[i], fringeState, mine) != candidateState.counts[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ColumnFringe::materializeSuccessorState(const FringeState &fringeState, bool mine, FringeState &successorState) const
+{
+    if(!successorDense)
+    {
+        for(int i = 0; i < successorSlots.size(); ++i)
+        {
+            successorState.counts[i] = slotValue(successorSlots[i], fringeState, mine);
+        }
+    }
+}
+
+void ColumnFringe::chooseEncoding(qint64 maxDenseStateSpace)
+{
+    stateSpaceSize = 1;
+
+    for(FringeCell &cell : cells)
+    {
+        cell.stride = stateSpaceSize;
+
+        // a cell with an empty range can't occur in a legal state, but it still needs a place in the index
+        stateSpaceSize *= std::max(1, cell.maxCount - cell.minCount + 1);
+
+        if(stateSpaceSize > maxDenseStateSpace)
+        {// too many possible states for an array, fall back to hashing the counts
+            dense = false;
+            stateSpaceSize = 0;
+
+            return;
+        }
+    }
+
+    dense = true;
+}
+
+void ColumnFringe::linkSuccessorEncoding(const ColumnFringe &successor)
+{
+    successorDense = successor.dense;
+
+    for(int i = 0; i < successorSlots.size(); ++i)
+    {
+        successorSlots[i].successorMinCount = successor.cells[i].minCount;
+        successorSlots[i].successorStride = successor.cells[i].stride;
+    }
+}
+
+quint64 ColumnFringe::zobristKey(int cellId, MineStatus count) const
+{
+    return zobristKeys[cellId * ZOBRIST_COUNTS + count];
+}
+
+MineStatus ColumnFringe::slotValue(const SuccessorSlot &slot, const FringeState &fringeState, bool mine) const
+{
+    MineStatus value = slot.sourceIndex >= 0? getCount(fringeState, slot.sourceIndex) : slot.startingCount;
+
+    if(mine && slot.adjacentToChoice)
+    {
+        // the count cell has a new adjacent mine, so the remaining count goes down by one
+        --value;
+    }
+
+    return value;
+}
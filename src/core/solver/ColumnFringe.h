@@ -0,0 +1,123 @@
+#ifndef COLUMNFRINGE_H
+#define COLUMNFRINGE_H
+
+#include "MineStatus.h"
+
+#include <QList>
+#include <QPair>
+#include <QVector>
+
+class SolverMinefield;
+
+typedef QPair<int, int> Coordinate;
+typedef QVector<Coordinate> CoordVector;
+
+// the fringe of a column is the set of count cells that have been influenced by the path before the column's cell and are not yet closed by it
+// these are the only count cells whose values can differ between the states in a column, so the states only need to store them
+// this class knows the fringe of one column and how choosing the column's cell turns a state of it into a state of the next column's fringe
+class ColumnFringe
+{
+public:
+    ColumnFringe() = default;
+
+    // dense fringes keep an array with an entry for every index while their column is being built, this bounds its size
+    static const qint64 MAX_DENSE_STATE_SPACE = 4 * 1024 * 1024;
+
+    // builds the fringe for every column of the path plus the final column, which always has an empty fringe
+    // a fringe with more possible states than the limit hashes its counts instead of indexing them
+    static QList<ColumnFringe> buildFringes(const SolverMinefield& startingMinefield, const CoordVector& path, qint64 maxDenseStateSpace = MAX_DENSE_STATE_SPACE);
+
+    struct FringeCell
+    {
+        // count cells adjacent to the path get a dense id so they can be identified without coordinates
+        int id = -1;
+        Coordinate coord;
+        // the count of the cell in the starting minefield
+        MineStatus startingCount = 0;
+        // unknown cells adjacent to this one that the path has not visited before this column
+        int remainingUnknowns = 0;
+
+        // the range of counts the cell can have in a legal state of this column
+        MineStatus minCount = 0;
+        MineStatus maxCount = 0;
+        // the place value of the cell in the mixed radix index of dense fringes
+        qint64 stride = 0;
+    };
+
+    // a state of the fringe
+    // small fringes are dense and identify their states by a mixed radix index over the possible counts of each cell
+    // larger fringes store the count of each cell instead since the index would be too large to use
+    // those also carry a zobrist hash of the counts that is updated incrementally from the previous state
+    // the counts are owned by the solver's arena along with the node that holds the state
+    struct FringeState
+    {
+        qint64 index = 0;
+        quint64 hash = 0;
+        MineStatus *counts = nullptr;
+    };
+
+    const QVector<FringeCell> &getCells() const;
+    int size() const;
+
+    bool isDense() const;
+    // the number of distinct indices a dense fringe's states can have
+    qint64 getStateSpaceSize() const;
+
+    // the state of a fringe with no cells in it, which is the state of the first column
+    FringeState emptyState() const;
+
+    MineStatus getCount(const FringeState& state, int cellIndex) const;
+
+    // computes the key of the next column's state if this column's cell is a mine or clear
+    // returns false if the choice violates a count cell, in which case there is no successor state
+    // for dense successors the key is the whole state, for hashed successors only the hash is computed
+    // the counts are left out because the successor usually already exists in the next column
+    bool chooseCellState(const FringeState& fringeState, bool mine, FringeState& successorState) const;
+
+    // checks whether an existing state of the next column is the successor, without building the successor's counts
+    bool successorMatches(const FringeState& fringeState, bool mine, const FringeState& candidateState) const;
+    // fills in the counts of a hashed successor once it's known to be a new state
+    // the successor's counts need to already point at storage for every cell of the next column's fringe
+    void materializeSuccessorState(const FringeState& fringeState, bool mine, FringeState& successorState) const;
+
+private:
+    struct SuccessorSlot
+    {
+        int id = -1;
+        // index of the cell in this column's fringe, -1 if the cell enters the fringe with this column's choice
+        int sourceIndex = -1;
+        MineStatus startingCount = 0;
+        bool adjacentToChoice = false;
+        // unknown cells adjacent to the count cell left after this column's choice
+        int remainingUnknowns = 0;
+
+        // the encoding of the cell in the next column's fringe, if it is dense
+        MineStatus successorMinCount = 0;
+        qint64 successorStride = 0;
+    };
+
+    QVector<FringeCell> cells;
+
+    bool dense = false;
+    qint64 stateSpaceSize = 0;
+
+    // one slot for each cell in the next column's fringe, in the order of the next column's fringe
+    QVector<SuccessorSlot> successorSlots;
+    // count cells adjacent to this column's cell that are closed by the choice, they must reach exactly zero
+    QVector<SuccessorSlot> closedSlots;
+    // the successor slots whose count can change with the choice
+    QVector<int> adjacentSlots;
+
+    // shared by every column's fringe, indexed by cell id and count
+    QVector<quint64> zobristKeys;
+
+    bool successorDense = false;
+
+    void chooseEncoding(qint64 maxDenseStateSpace);
+    void linkSuccessorEncoding(const ColumnFringe& successor);
+
+    quint64 zobristKey(int cellId, MineStatus count) const;
+    MineStatus slotValue(const SuccessorSlot& slot, const FringeState& fringeState, bool mine) const;
+};
+
+#endif // COLUMNFRINGE_H
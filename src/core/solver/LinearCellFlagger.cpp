@@ -0,0 +1,492 @@
+#include "LinearCellFlagger.h"
+
+#include <algorithm>
+
+// the coefficients and constants stay well inside 64 bits even when multiplied by a bound and summed over the whole board
+static const qint64 MAX_COEFFICIENT = Q_INT64_C(1) << 24;
+// the elimination fills in the equations of large regions, long ones rarely bound anything so they're dropped
+static const int MAX_EQUATION_TERMS = 64;
+
+static qint64 greatestCommonDivisor(qint64 a, qint64 b)
+{
+    a = std::abs(a);
+    b = std::abs(b);
+
+    while(b != 0)
+    {
+        qint64 remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+
+    return a;
+}
+
+static qint64 divideRoundingDown(qint64 numerator, qint64 denominator)
+{
+    qint64 quotient = numerator / denominator;
+
+    return (numerator % denominator != 0 && (numerator < 0) != (denominator < 0))? quotient - 1 : quotient;
+}
+
+static qint64 divideRoundingUp(qint64 numerator, qint64 denominator)
+{
+    return -divideRoundingDown(-numerator, denominator);
+}
+
+// divides the equation through by what its coefficients have in common, false if the constant doesn't divide, which means there's no integer solution
+static bool normalizeEquation(QVector<qint64>& coefficients, qint64& constant)
+{
+    qint64 divisor = 0;
+
+    for(qint64 coefficient : coefficients)
+    {
+        divisor = greatestCommonDivisor(divisor, coefficient);
+    }
+
+    if(divisor == 0 || constant % divisor != 0)
+    {
+        return divisor == 0 && constant == 0;
+    }
+
+    for(qint64& coefficient : coefficients)
+    {
+        coefficient /= divisor;
+    }
+
+    constant /= divisor;
+
+    return true;
+}
+
+LinearCellFlagger::LinearCellFlagger(const SolverMinefield &minefield, int mineCount)
+    : minefield(minefield), mineCount(mineCount)
+{
+
+}
+
+const QHash<Coordinate, double> &LinearCellFlagger::getChancesToBeMine() const
+{
+    return chancesToBeMine;
+}
+
+void LinearCellFlagger::flagLinearCells()
+{
+    buildVariables();
+
+    int variableCount = lowerBounds.size();
+    int restVariable = variableCount - 1;
+
+    QHash<Coordinate, int> cellVariables;
+
+    for(int i = 0; i < cells.size(); ++i)
+    {
+        cellVariables.insert(cells[i], i);
+    }
+
+    pivotEquations.fill(-1, variableCount);
+    variableEquations.resize(variableCount);
+    reduction.fill(0, variableCount);
+    reductionTouched.fill(false, variableCount);
+
+    // every count cell says its unknowns hold exactly its count of mines
+    minefield.traverseCells([&] (int x, int y) -> void {
+        MineStatus status = minefield.getCell(x, y);
+
+        if(status < 0)
+        {
+            return;
+        }
+
+        Equation equation;
+        equation.constant = status;
+
+        minefield.traverseAdjacentCells(x, y, [&] (int x, int y) -> void {
+            if(cellVariables.contains({x, y}))
+            {
+                equation.terms.append({cellVariables[{x, y}], 1});
+            }
+        });
+
+        if(!equation.terms.isEmpty())
+        {
+            std::sort(equation.terms.begin(), equation.terms.end(), [] (const Term& a, const Term& b) {return a.variable < b.variable;});
+
+            addEquation(equation, -1, false);
+        }
+    });
+
+    // and every unknown cell together holds the rest of the mines
+    // the variable for the cells away from the counts is only in this equation, so making it the pivot leaves the others alone
+    Equation mineCountEquation;
+    mineCountEquation.constant = mineCount;
+
+    for(int i = 0; i < variableCount; ++i)
+    {
+        mineCountEquation.terms.append({i, 1});
+    }
+
+    addEquation(mineCountEquation, restVariable, true);
+
+    if(!tightenBounds())
+    {// the counts contradict each other, there's nothing to say about any cell and the solver will find no legal minefields
+        return;
+    }
+
+    for(int i = 0; i < cells.size(); ++i)
+    {
+        if(lowerBounds[i] == upperBounds[i])
+        {
+            chancesToBeMine.insert(cells[i], lowerBounds[i]);
+        }
+    }
+}
+
+void LinearCellFlagger::buildVariables()
+{
+    int restCellCount = 0;
+
+    minefield.traverseCells([&] (int x, int y) -> void {
+        MineStatus status = minefield.getCell(x, y);
+
+        if(status >= 0 || status == SpecialStatus::Visited)
+        {
+            return;
+        }
+
+        bool nextToCount = false;
+
+        minefield.traverseAdjacentCells(x, y, [&] (int x, int y) -> void {
+            nextToCount = nextToCount || minefield.getCell(x, y) >= 0;
+        });
+
+        if(nextToCount)
+        {
+            cells.append({x, y});
+        }
+        else
+        {
+            ++restCellCount;
+        }
+    });
+
+    lowerBounds.fill(0, cells.size() + 1);
+    upperBounds.fill(1, cells.size() + 1);
+    upperBounds.last() = restCellCount;
+}
+
+void LinearCellFlagger::addEquation(const Equation &equation, int preferredPivot, bool allowLong)
+{
+    // the equation is gathered densely so reducing a long one by many pivots doesn't copy it for each
+    QVector<int> touched;
+    qint64 constant = equation.constant;
+
+    for(const Term& term : equation.terms)
+    {
+        reduction[term.variable] = term.coefficient;
+        reductionTouched[term.variable] = true;
+        touched.append(term.variable);
+    }
+
+    auto clearReduction = [&] () {
+        for(int variable : touched)
+        {
+            reduction[variable] = 0;
+            reductionTouched[variable] = false;
+        }
+    };
+
+    // pivot equations only have variables that aren't pivots besides their own, so only the equation's own variables need reducing
+    int ownVariableCount = touched.size();
+
+    for(int i = 0; i < ownVariableCount; ++i)
+    {
+        int variable = touched[i];
+        qint64 coefficient = reduction[variable];
+        int pivot = pivotEquations[variable];
+
+        if(coefficient == 0 || pivot < 0)
+        {
+            continue;
+        }
+
+        const Equation& pivotEquation = equations[pivot];
+        qint64 divisor = greatestCommonDivisor(coefficient, pivotEquation.pivotCoefficient);
+        qint64 scale = pivotEquation.pivotCoefficient / divisor;
+        qint64 factor = coefficient / divisor;
+
+        // scale * equation - factor * pivot equation cancels the variable
+        // only the scaling touches the whole equation, which only happens when the pivot's coefficient doesn't divide this one
+        bool tooLarge = false;
+
+        if(scale != 1)
+        {
+            for(int other : touched)
+            {
+                reduction[other] *= scale;
+                tooLarge = tooLarge || std::abs(reduction[other]) > MAX_COEFFICIENT;
+            }
+
+            constant *= scale;
+        }
+
+        for(const Term& term : pivotEquation.terms)
+        {
+            if(!reductionTouched[term.variable])
+            {
+                reductionTouched[term.variable] = true;
+                touched.append(term.variable);
+            }
+
+            reduction[term.variable] -= factor * term.coefficient;
+            tooLarge = tooLarge || std::abs(reduction[term.variable]) > MAX_COEFFICIENT;
+        }
+
+        constant -= factor * pivotEquation.constant;
+
+        if(tooLarge || std::abs(constant) > MAX_COEFFICIENT)
+        {
+            clearReduction();
+            return;
+        }
+    }
+
+    std::sort(touched.begin(), touched.end());
+
+    Equation reduced;
+    QVector<qint64> coefficients;
+
+    for(int variable : touched)
+    {
+        if(reduction[variable] != 0)
+        {
+            reduced.terms.append({variable, reduction[variable]});
+            coefficients.append(reduction[variable]);
+        }
+    }
+
+    clearReduction();
+
+    reduced.constant = constant;
+
+    // an equation with nothing left was implied by the others, or contradicts them if its constant isn't 0, which the bounds find anyway
+    if(reduced.terms.isEmpty() || !normalizeEquation(coefficients, reduced.constant) || (!allowLong && reduced.terms.size() > MAX_EQUATION_TERMS))
+    {
+        return;
+    }
+
+    for(int i = 0; i < reduced.terms.size(); ++i)
+    {
+        reduced.terms[i].coefficient = coefficients[i];
+    }
+
+    // pivots of 1 keep the other equations from growing when it's eliminated from them
+    for(const Term& term : reduced.terms)
+    {
+        if(term.variable == preferredPivot || (preferredPivot < 0 && reduced.pivot < 0 && std::abs(term.coefficient) == 1))
+        {
+            reduced.pivot = term.variable;
+            reduced.pivotCoefficient = term.coefficient;
+        }
+    }
+
+    if(reduced.pivot < 0)
+    {
+        reduced.pivot = reduced.terms.first().variable;
+        reduced.pivotCoefficient = reduced.terms.first().coefficient;
+    }
+
+    int index = equations.size();
+    equations.append(reduced);
+    pivotEquations[reduced.pivot] = index;
+
+    for(const Term& term : reduced.terms)
+    {
+        variableEquations[term.variable].append(index);
+    }
+
+    // the new pivot is taken out of every earlier equation so each equation keeps only one pivot
+    QVector<int> containing = variableEquations[reduced.pivot];
+
+    for(int other : containing)
+    {
+        if(other == index || !equations[other].live)
+        {
+            continue;
+        }
+
+        QVector<Term> previousTerms = equations[other].terms;
+
+        if(!eliminate(equations[other], equations[index]))
+        {
+            dropEquation(other);
+            continue;
+        }
+
+        for(const Term& term : equations[other].terms)
+        {
+            auto previous = std::lower_bound(previousTerms.begin(), previousTerms.end(), term.variable, [] (const Term& a, int variable) {return a.variable < variable;});
+
+            if(previous == previousTerms.end() || previous->variable != term.variable)
+            {
+                variableEquations[term.variable].append(other);
+            }
+        }
+    }
+}
+
+bool LinearCellFlagger::eliminate(Equation &equation, const Equation &pivotEquation) const
+{
+    auto found = std::lower_bound(equation.terms.begin(), equation.terms.end(), pivotEquation.pivot, [] (const Term& a, int variable) {return a.variable < variable;});
+
+    if(found == equation.terms.end() || found->variable != pivotEquation.pivot)
+    {// it was already eliminated
+        return true;
+    }
+
+    qint64 divisor = greatestCommonDivisor(found->coefficient, pivotEquation.pivotCoefficient);
+    qint64 scale = pivotEquation.pivotCoefficient / divisor;
+    qint64 factor = found->coefficient / divisor;
+
+    // both are sorted by variable, so this merges them
+    QVector<Term> terms;
+    QVector<qint64> coefficients;
+    int i = 0;
+    int j = 0;
+
+    while(i < equation.terms.size() || j < pivotEquation.terms.size())
+    {
+        Term term;
+
+        if(j == pivotEquation.terms.size() || (i < equation.terms.size() && equation.terms[i].variable < pivotEquation.terms[j].variable))
+        {
+            term = {equation.terms[i].variable, scale * equation.terms[i].coefficient};
+            ++i;
+        }
+        else if(i == equation.terms.size() || pivotEquation.terms[j].variable < equation.terms[i].variable)
+        {
+            term = {pivotEquation.terms[j].variable, -factor * pivotEquation.terms[j].coefficient};
+            ++j;
+        }
+        else
+        {
+            term = {equation.terms[i].variable, scale * equation.terms[i].coefficient - factor * pivotEquation.terms[j].coefficient};
+            ++i;
+            ++j;
+        }
+
+        if(term.coefficient != 0)
+        {
+            if(std::abs(term.coefficient) > MAX_COEFFICIENT)
+            {
+                return false;
+            }
+
+            terms.append(term);
+            coefficients.append(term.coefficient);
+        }
+    }
+
+    qint64 constant = scale * equation.constant - factor * pivotEquation.constant;
+
+    if(std::abs(constant) > MAX_COEFFICIENT || terms.isEmpty() || terms.size() > MAX_EQUATION_TERMS || !normalizeEquation(coefficients, constant))
+    {
+        return false;
+    }
+
+    for(int k = 0; k < terms.size(); ++k)
+    {
+        terms[k].coefficient = coefficients[k];
+
+        if(terms[k].variable == equation.pivot)
+        {
+            equation.pivotCoefficient = coefficients[k];
+        }
+    }
+
+    equation.terms = terms;
+    equation.constant = constant;
+
+    return true;
+}
+
+void LinearCellFlagger::dropEquation(int index)
+{
+    Equation& equation = equations[index];
+
+    equation.live = false;
+
+    if(pivotEquations[equation.pivot] == index)
+    {
+        pivotEquations[equation.pivot] = -1;
+    }
+}
+
+bool LinearCellFlagger::tightenBounds()
+{
+    // a term can only take values its variable's range allows, so the rest of its equation has to make up the difference
+    // that bounds the term in turn, and tighter bounds can tighten other equations, so this goes until nothing changes
+    bool tightened = true;
+
+    while(tightened)
+    {
+        tightened = false;
+
+        for(const Equation& equation : equations)
+        {
+            if(!equation.live)
+            {
+                continue;
+            }
+
+            qint64 least = 0;
+            qint64 most = 0;
+
+            for(const Term& term : equation.terms)
+            {
+                qint64 low = term.coefficient * lowerBounds[term.variable];
+                qint64 high = term.coefficient * upperBounds[term.variable];
+
+                least += std::min(low, high);
+                most += std::max(low, high);
+            }
+
+            if(equation.constant < least || equation.constant > most)
+            {
+                return false;
+            }
+
+            for(const Term& term : equation.terms)
+            {
+                qint64 low = term.coefficient * lowerBounds[term.variable];
+                qint64 high = term.coefficient * upperBounds[term.variable];
+
+                // the term has to be within these for the rest to be able to make up the constant
+                qint64 termLeast = equation.constant - (most - std::max(low, high));
+                qint64 termMost = equation.constant - (least - std::min(low, high));
+
+                qint64 lower = term.coefficient > 0? divideRoundingUp(termLeast, term.coefficient) : divideRoundingUp(termMost, term.coefficient);
+                qint64 upper = term.coefficient > 0? divideRoundingDown(termMost, term.coefficient) : divideRoundingDown(termLeast, term.coefficient);
+
+                if(lower > lowerBounds[term.variable])
+                {
+                    lowerBounds[term.variable] = lower;
+                    tightened = true;
+                }
+
+                if(upper < upperBounds[term.variable])
+                {
+                    upperBounds[term.variable] = upper;
+                    tightened = true;
+                }
+
+                if(lowerBounds[term.variable] > upperBounds[term.variable])
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef LINEARCELLFLAGGER_H
+#define LINEARCELLFLAGGER_H
+
+#include "SolverMinefield.h"
+
+#include <QHash>
+#include <QVector>
+
+typedef QPair<int, int> Coordinate;
+typedef QVector<Coordinate> CoordVector;
+
+// finds cells that have to be mines or clear by treating every count cell as an equation over its unknowns
+// the equations are reduced by gaussian elimination over the integers, then every reduced equation bounds the cells in it
+// this settles cells that no single count cell or pair of them can, before any of the exponential work
+class LinearCellFlagger
+{
+public:
+    // the mine count is one more equation, over every unknown cell
+    LinearCellFlagger(const SolverMinefield& minefield, int mineCount);
+
+    const QHash<Coordinate, double> &getChancesToBeMine() const;
+
+    void flagLinearCells();
+
+private:
+    struct Term
+    {
+        int variable = 0;
+        qint64 coefficient = 0;
+    };
+
+    // the terms add up to the constant, they're sorted by variable
+    struct Equation
+    {
+        QVector<Term> terms;
+        qint64 constant = 0;
+
+        int pivot = -1;
+        qint64 pivotCoefficient = 0;
+
+        // equations whose coefficients grew too large are dropped, which loses what they said but never says anything wrong
+        bool live = true;
+    };
+
+    SolverMinefield minefield;
+    int mineCount = 0;
+
+    QHash<Coordinate, double> chancesToBeMine;
+
+    // a variable for each unknown cell next to a count cell, and a last one for how many mines the rest of the unknown cells hold
+    CoordVector cells;
+    QVector<qint64> lowerBounds;
+    QVector<qint64> upperBounds;
+
+    QVector<Equation> equations;
+    // the equation each variable is the pivot of, or -1
+    QVector<int> pivotEquations;
+    // the equations each variable was ever in, some may have had it eliminated since
+    QVector<QVector<int>> variableEquations;
+
+    // scratch space for reducing an equation, indexed by variable
+    QVector<qint64> reduction;
+    QVector<bool> reductionTouched;
+
+    void buildVariables();
+    // reduces the equation by the pivots so far, makes it the pivot of one of its variables and eliminates that variable from the others
+    void addEquation(const Equation& equation, int preferredPivot, bool allowLong);
+    // cancels the pivot's variable out of the equation, false if that makes it too large to keep
+    bool eliminate(Equation& equation, const Equation& pivotEquation) const;
+    void dropEquation(int index);
+
+    // narrows the range of every variable from what the equations allow, false if some equation can't be met at all
+    bool tightenBounds();
+};
+
+#endif // LINEARCELLFLAGGER_H
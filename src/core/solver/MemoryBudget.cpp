@@ -0,0 +1,57 @@
+#include "MemoryBudget.h"
+
+void MemoryBudget::setLimit(qsizetype bytes)
+{
+    limit = bytes;
+}
+
+qsizetype MemoryBudget::getLimit() const
+{
+    return limit;
+}
+
+void MemoryBudget::allocate(qsizetype bytes)
+{
+    qint64 used = usedBytes.fetchAndAddRelaxed(bytes) + bytes;
+    qint64 peak = peakBytes.loadRelaxed();
+
+    while(used > peak && !peakBytes.testAndSetRelaxed(peak, used, peak))
+    {// another thread raised the peak first, try again against its value
+    }
+
+    if(limit >= 0 && used > limit)
+    {
+        exceeded.storeRelaxed(1);
+    }
+}
+
+void MemoryBudget::release(qsizetype bytes)
+{
+    usedBytes.fetchAndSubRelaxed(bytes);
+}
+
+qsizetype MemoryBudget::getUsedBytes() const
+{
+    return usedBytes.loadRelaxed();
+}
+
+qsizetype MemoryBudget::getPeakBytes() const
+{
+    return peakBytes.loadRelaxed();
+}
+
+bool MemoryBudget::isExceeded() const
+{
+    return exceeded.loadRelaxed() != 0;
+}
+
+void MemoryBudget::markExceeded()
+{
+    exceeded.storeRelaxed(1);
+}
+
+void MemoryBudget::reset()
+{
+    usedBytes.storeRelaxed(0);
+    exceeded.storeRelaxed(0);
+}
@@ -0,0 +1,40 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QAtomicInteger>
+#include <QtGlobal>
+
+// keeps a running total of the bytes a solve's graph holds, so the solve can stop before it takes more than it's allowed
+// the total covers the nodes, their states, the edges, the state lookups and the path counts, not every last allocation
+// safe to use from any thread
+class MemoryBudget
+{
+public:
+    // a negative limit never runs out
+    void setLimit(qsizetype bytes);
+    qsizetype getLimit() const;
+
+    // the bytes are counted even if they go over the limit, which marks the budget exceeded
+    void allocate(qsizetype bytes);
+    void release(qsizetype bytes);
+
+    qsizetype getUsedBytes() const;
+    qsizetype getPeakBytes() const;
+
+    // once exceeded this stays set until it's reset, even if bytes are released
+    bool isExceeded() const;
+    // for when the bytes were held somewhere else, like the graph of another solve
+    void markExceeded();
+
+    // after the graph is freed, the used bytes go back to zero and the budget can be used again
+    void reset();
+
+private:
+    qsizetype limit = -1;
+
+    QAtomicInteger<qint64> usedBytes;
+    QAtomicInteger<qint64> peakBytes;
+    QAtomicInt exceeded;
+};
+
+#endif // MEMORYBUDGET_H
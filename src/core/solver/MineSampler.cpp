@@ -0,0 +1,477 @@
+#include "MineSampler.h"
+
+#include <QHash>
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+MineSampler::MineSampler(const SolverMinefield &minefield, const CoordVector &path, int tailPathCellCount, int mineCount, int chainCount)
+    : tailPathCellCount(tailPathCellCount), mineCount(mineCount)
+{
+    QHash<Coordinate, int> countCellIndices;
+
+    cellCountCells.resize(path.size());
+
+    for(int i = 0; i < path.size(); ++i)
+    {
+        minefield.traverseAdjacentCells(path[i].first, path[i].second, [&] (int x, int y) -> void {
+            MineStatus status = minefield.getCell(x, y);
+
+            if(status >= 0)
+            {
+                if(!countCellIndices.contains({x, y}))
+                {
+                    countCellIndices.insert({x, y}, countCellTargets.size());
+                    countCellTargets.append(status);
+                }
+
+                cellCountCells[i].append(countCellIndices.value({x, y}));
+            }
+        });
+    }
+
+    countCellUnknowns.resize(countCellTargets.size());
+    countCellNeighbors.resize(countCellTargets.size());
+
+    for(int i = 0; i < path.size(); ++i)
+    {
+        for(int countCell : cellCountCells[i])
+        {
+            countCellUnknowns[countCell].append(i);
+
+            for(int neighbor : cellCountCells[i])
+            {
+                if(neighbor != countCell && !countCellNeighbors[countCell].contains(neighbor))
+                {
+                    countCellNeighbors[countCell].append(neighbor);
+                }
+            }
+        }
+    }
+
+    logTailWays.resize(tailPathCellCount + 1);
+
+    for(int k = 0; k <= tailPathCellCount; ++k)
+    {
+        logTailWays[k] = std::lgamma(tailPathCellCount + 1.0) - std::lgamma(k + 1.0) - std::lgamma(tailPathCellCount - k + 1.0);
+    }
+
+    std::random_device seeder;
+
+    chains.resize(qMax(1, chainCount));
+
+    for(Chain &chain : chains)
+    {
+        chain.random.seed((static_cast<quint64>(seeder()) << 32) | seeder());
+        chain.mines.fill(false, path.size());
+        chain.countCellMines.fill(0, countCellTargets.size());
+        chain.mineTallies.fill(0, path.size() + 1);
+        chain.batchTallies.fill(0, path.size() + 1);
+        chain.batchChanceSums.fill(0, path.size() + 1);
+        chain.batchChanceSquares.fill(0, path.size() + 1);
+
+        for(int target : countCellTargets)
+        {
+            chain.violation += target;
+        }
+
+        // the tail path can't hold every mine, so the chain starts with the rest in random path cells
+        int startingPathMines = qMin(static_cast<int>(path.size()), qMax(0, mineCount - tailPathCellCount));
+
+        while(chain.pathMines < startingPathMines)
+        {
+            int cell = std::uniform_int_distribution<int>(0, path.size() - 1)(chain.random);
+
+            if(!chain.mines[cell])
+            {
+                flip(chain, cell);
+            }
+        }
+    }
+}
+
+void MineSampler::sample(int sweeps, const CancellationToken *token)
+{
+    // map seems to hate lambdas
+    QtConcurrent::map(chains, std::bind(&runChain, std::placeholders::_1, this, sweeps, token)).waitForFinished();
+}
+
+double MineSampler::getChanceToBeMine(int pathIndex) const
+{
+    double chance;
+    double error;
+
+    estimate(pathIndex, chance, error);
+
+    return chance;
+}
+
+double MineSampler::getChanceError(int pathIndex) const
+{
+    double chance;
+    double error;
+
+    estimate(pathIndex, chance, error);
+
+    return error;
+}
+
+double MineSampler::getTailChanceToBeMine() const
+{
+    double chance;
+    double error;
+
+    estimate(cellCountCells.size(), chance, error);
+
+    return chance;
+}
+
+double MineSampler::getTailChanceError() const
+{
+    double chance;
+    double error;
+
+    estimate(cellCountCells.size(), chance, error);
+
+    return error;
+}
+
+qint64 MineSampler::getSampleCount() const
+{
+    qint64 sampleCount = 0;
+
+    for(const Chain &chain : chains)
+    {
+        sampleCount += chain.sampleCount;
+    }
+
+    return sampleCount;
+}
+
+void MineSampler::runChain(Chain &chain, const MineSampler *sampler, int sweeps, const CancellationToken *token)
+{
+    int countCellCount = sampler->countCellTargets.size();
+
+    if(countCellCount == 0)
+    {// nothing to wander over, the only minefield puts every mine in the tail path
+        if(sampler->mineCount <= sampler->tailPathCellCount)
+        {
+            for(int sweep = 0; sweep < sweeps; ++sweep)
+            {
+                sampler->tally(chain);
+            }
+        }
+
+        return;
+    }
+
+    std::uniform_int_distribution<int> anyCountCell(0, countCellCount - 1);
+
+    QVector<int> block;
+    QVector<int> blockCountCells;
+    QVector<double> logWeights;
+    QVector<int> violatedCountCells;
+
+    for(int sweep = 0; sweep < sweeps; ++sweep)
+    {
+        if(token && token->isCancelled())
+        {
+            return;
+        }
+
+        if(!chain.burnedIn)
+        {// while burning in the chain doesn't have to keep its distribution, so it also goes straight for the counts it's missing
+            violatedCountCells.clear();
+
+            for(int countCell = 0; countCell < countCellCount; ++countCell)
+            {
+                if(chain.countCellMines[countCell] != sampler->countCellTargets[countCell])
+                {
+                    violatedCountCells.append(countCell);
+                }
+            }
+
+            for(int countCell : violatedCountCells)
+            {
+                sampler->buildBlock(chain, countCell, block, blockCountCells);
+                sampler->updateBlock(chain, block, logWeights);
+            }
+        }
+
+        for(int i = 0; i < countCellCount; ++i)
+        {
+            // the block only depends on the draws, never on the minefield, so redrawing it leaves the chain's distribution where it is
+            sampler->buildBlock(chain, anyCountCell(chain.random), block, blockCountCells);
+            sampler->updateBlock(chain, block, logWeights);
+        }
+
+        ++chain.sweeps;
+
+        if(!chain.burnedIn)
+        {
+            chain.windowLegalSweeps += chain.violation == 0;
+
+            if(chain.sweeps % PENALTY_WINDOW_SWEEPS == 0)
+            {
+                // the chain is ready once it's burned in long enough and has settled somewhere it can find legal minefields
+                chain.burnedIn = chain.sweeps >= BURN_IN_SWEEPS && chain.windowLegalSweeps > 0;
+
+                tunePenalty(chain);
+            }
+
+            continue;
+        }
+
+        sampler->tally(chain);
+    }
+}
+
+void MineSampler::tunePenalty(Chain &chain)
+{
+    if(!chain.burnedIn)
+    {
+        if(4 * chain.windowLegalSweeps < PENALTY_WINDOW_SWEEPS)
+        {
+            chain.penalty = std::min(MAX_PENALTY, chain.penalty + 1);
+        }
+        else if(4 * chain.windowLegalSweeps > 3 * PENALTY_WINDOW_SWEEPS)
+        {
+            chain.penalty = std::max(1.0, chain.penalty - 0.5);
+        }
+    }
+
+    chain.windowLegalSweeps = 0;
+}
+
+void MineSampler::tally(Chain &chain) const
+{
+    int cellCount = chain.mines.size();
+
+    if(chain.violation == 0)
+    {
+        ++chain.batchSampleCount;
+
+        for(int cell = 0; cell < cellCount; ++cell)
+        {
+            chain.batchTallies[cell] += chain.mines[cell];
+        }
+
+        chain.batchTallies[cellCount] += mineCount - chain.pathMines;
+    }
+
+    if(++chain.batchSweeps < BATCH_SWEEPS)
+    {
+        return;
+    }
+
+    if(chain.batchSampleCount > 0)
+    {
+        ++chain.batchCount;
+        chain.sampleCount += chain.batchSampleCount;
+
+        for(int i = 0; i <= cellCount; ++i)
+        {
+            double batchChance = chanceScale(i) * chain.batchTallies[i] / chain.batchSampleCount;
+
+            chain.mineTallies[i] += chain.batchTallies[i];
+            chain.batchChanceSums[i] += batchChance;
+            chain.batchChanceSquares[i] += batchChance * batchChance;
+        }
+    }
+
+    chain.batchSweeps = 0;
+    chain.batchSampleCount = 0;
+    chain.batchTallies.fill(0);
+}
+
+void MineSampler::buildBlock(Chain &chain, int countCell, QVector<int> &block, QVector<int> &blockCountCells) const
+{
+    block.clear();
+    blockCountCells.clear();
+
+    // grows out from the count cell through random neighbors, so mines can move along a few counts at once without breaking any
+    for(int attempt = 0; attempt < MAX_BLOCK_CELLS && block.size() < MAX_BLOCK_CELLS; ++attempt)
+    {
+        if(!blockCountCells.isEmpty())
+        {
+            int from = blockCountCells[std::uniform_int_distribution<int>(0, blockCountCells.size() - 1)(chain.random)];
+            const QVector<int> &neighbors = countCellNeighbors[from];
+
+            if(neighbors.isEmpty())
+            {
+                break;
+            }
+
+            countCell = neighbors[std::uniform_int_distribution<int>(0, neighbors.size() - 1)(chain.random)];
+
+            if(blockCountCells.contains(countCell))
+            {
+                continue;
+            }
+        }
+
+        blockCountCells.append(countCell);
+
+        for(int cell : countCellUnknowns[countCell])
+        {
+            if(block.size() < MAX_BLOCK_CELLS && !block.contains(cell))
+            {
+                block.append(cell);
+            }
+        }
+    }
+}
+
+void MineSampler::updateBlock(Chain &chain, const QVector<int> &block, QVector<double> &logWeights) const
+{
+    int stateCount = 1 << block.size();
+
+    logWeights.resize(stateCount);
+
+    // the states are walked in gray code order so each is a single flip from the last, they're indexed by which cells differ from where the block started
+    int state = 0;
+    logWeights[0] = logWeight(chain);
+
+    for(int i = 1; i < stateCount; ++i)
+    {
+        int bit = qCountTrailingZeroBits(static_cast<quint32>(i));
+
+        flip(chain, block[bit]);
+        state ^= 1 << bit;
+
+        logWeights[state] = logWeight(chain);
+    }
+
+    double maxLogWeight = *std::max_element(logWeights.constBegin(), logWeights.constEnd());
+    double totalWeight = 0;
+
+    for(double &weight : logWeights)
+    {// the chain's minefield has a finite weight, so the largest one always does
+        // most of a block's states miss several counts, they're too unlikely to ever be drawn so they're not worth an exp
+        weight = weight > maxLogWeight - NEGLIGIBLE_LOG_WEIGHT? std::exp(weight - maxLogWeight) : 0;
+        totalWeight += weight;
+    }
+
+    double draw = std::uniform_real_distribution<double>(0, totalWeight)(chain.random);
+    int chosenState = stateCount - 1;
+
+    for(int i = 0; i < stateCount; ++i)
+    {
+        draw -= logWeights[i];
+
+        if(draw < 0)
+        {
+            chosenState = i;
+            break;
+        }
+    }
+
+    while(chosenState != state)
+    {
+        int bit = qCountTrailingZeroBits(static_cast<quint32>(chosenState ^ state));
+
+        flip(chain, block[bit]);
+        state ^= 1 << bit;
+    }
+}
+
+double MineSampler::logWeight(const Chain &chain) const
+{
+    int tailMines = mineCount - chain.pathMines;
+
+    if(tailMines < 0 || tailMines > tailPathCellCount)
+    {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    return logTailWays[tailMines] - chain.penalty * chain.violation;
+}
+
+void MineSampler::flip(Chain &chain, int cell) const
+{
+    int change = chain.mines[cell]? -1 : 1;
+
+    for(int countCell : cellCountCells[cell])
+    {
+        int mines = chain.countCellMines[countCell];
+        int target = countCellTargets[countCell];
+
+        chain.violation += std::abs(mines + change - target) - std::abs(mines - target);
+        chain.countCellMines[countCell] = mines + change;
+    }
+
+    chain.mines[cell] = !chain.mines[cell];
+    chain.pathMines += change;
+}
+
+void MineSampler::estimate(int index, double &chance, double &error) const
+{
+    // every chain is an independent estimate, so how much they disagree is where the error bars start
+    QVector<double> chainChances;
+    int batchCount = 0;
+    double batchChanceSum = 0;
+    double batchChanceSquares = 0;
+
+    for(const Chain &chain : chains)
+    {
+        if(chain.sampleCount > 0)
+        {
+            chainChances.append(chanceScale(index) * chain.mineTallies[index] / chain.sampleCount);
+
+            batchCount += chain.batchCount;
+            batchChanceSum += chain.batchChanceSums[index];
+            batchChanceSquares += chain.batchChanceSquares[index];
+        }
+    }
+
+    if(chainChances.size() < 2)
+    {// a single chain can't say how far off it might be
+        int cellCount = tailPathCellCount + cellCountCells.size();
+
+        chance = chainChances.isEmpty()? (cellCount > 0? static_cast<double>(mineCount) / cellCount : 0) : chainChances.first();
+        error = 0.5;
+
+        return;
+    }
+
+    double sum = 0;
+
+    for(double chainChance : chainChances)
+    {
+        sum += chainChance;
+    }
+
+    chance = sum / chainChances.size();
+
+    double squaredDeviations = 0;
+
+    for(double chainChance : chainChances)
+    {
+        squaredDeviations += (chainChance - chance) * (chainChance - chance);
+    }
+
+    error = std::sqrt(squaredDeviations / (chainChances.size() - 1) / chainChances.size());
+
+    if(batchCount > 1)
+    {
+        double batchVariance = (batchChanceSquares - batchChanceSum * batchChanceSum / batchCount) / (batchCount - 1);
+
+        error = std::max(error, std::sqrt(std::max(0.0, batchVariance) / batchCount));
+    }
+
+    // a short run can't tell how much it hasn't explored, so at best each batch counts as a single independent sample
+    // nudged away from 0 and 1 so a cell no batch had as a mine still gets some error
+    int independentSamples = std::max(1, batchCount);
+    double nudgedChance = (chance * independentSamples + 1) / (independentSamples + 2);
+
+    error = std::max(error, std::sqrt(nudgedChance * (1 - nudgedChance) / independentSamples));
+}
+
+double MineSampler::chanceScale(int index) const
+{
+    // the tail path's tally is its mines, which are spread over all of its cells
+    return index < cellCountCells.size() || tailPathCellCount == 0? 1.0 : 1.0 / tailPathCellCount;
+}
@@ -0,0 +1,126 @@
+#ifndef MINESAMPLER_H
+#define MINESAMPLER_H
+
+#include "CancellationToken.h"
+#include "SolverMinefield.h"
+
+#include <QPair>
+#include <QVector>
+
+#include <random>
+
+typedef QPair<int, int> Coordinate;
+typedef QVector<Coordinate> CoordVector;
+
+// estimates the chances by sampling minefields instead of counting them, for boards whose graphs would be too large to build
+// each chain is a markov chain over which path cells are mines, with the tail path only tracked by how many mines it holds
+// a chain can wander through minefields that break some counts, paying a penalty for each mine a count is off by
+// only the minefields that meet every count are tallied, which makes the tallies follow the chances of the legal minefields exactly
+// the memory used only grows with the number of cells and chains, never with how hard the board is
+class MineSampler
+{
+public:
+    // the minefield has the known cells marked already, the mine count is what's left for the path and tail path
+    MineSampler(const SolverMinefield& minefield, const CoordVector& path, int tailPathCellCount, int mineCount, int chainCount);
+
+    // runs every chain for this many sweeps, a sweep redraws as many blocks as there are count cells
+    // the chains run on the thread pool and stop early once the token is cancelled
+    void sample(int sweeps, const CancellationToken* token);
+
+    // the chances are the average over the chains that have burned in and tallied a legal minefield, the errors are standard errors
+    // until two chains have, the error is 0.5, and with no chains at all every cell gets the average density of mines
+    double getChanceToBeMine(int pathIndex) const;
+    double getChanceError(int pathIndex) const;
+    // the chance of each tail path cell
+    double getTailChanceToBeMine() const;
+    double getTailChanceError() const;
+
+    // the legal minefields tallied across every chain so far, counting only finished batches
+    qint64 getSampleCount() const;
+
+private:
+    // a block is the unknowns around a few neighboring count cells, every state they could take is weighed at once
+    static const int MAX_BLOCK_CELLS = 10;
+    // a block state this much less likely than the most likely one is never drawn
+    static constexpr double NEGLIGIBLE_LOG_WEIGHT = 40.0;
+
+    // a chain pays log weight for each mine a count is off by, this much to start with
+    static constexpr double STARTING_PENALTY = 2.0;
+    static constexpr double MAX_PENALTY = 16.0;
+    // while a chain burns in, it tunes its penalty this often so it spends between a quarter and three quarters of its sweeps in legal minefields
+    static const int PENALTY_WINDOW_SWEEPS = 8;
+    // the sweeps before a chain starts tallying, it also has to have found a legal minefield by then
+    static const int BURN_IN_SWEEPS = 64;
+    // the sweeps tallied together when the chances are compared from one stretch of a chain to the next
+    static const int BATCH_SWEEPS = 16;
+
+    struct Chain
+    {
+        std::mt19937_64 random;
+
+        QVector<bool> mines;
+        // the mines next to each count cell
+        QVector<int> countCellMines;
+        int pathMines = 0;
+        // how many mines the counts are off by in all
+        int violation = 0;
+
+        double penalty = STARTING_PENALTY;
+        qint64 sweeps = 0;
+        int windowLegalSweeps = 0;
+        bool burnedIn = false;
+
+        // the times each path cell was a mine in a legal minefield, with the tail path's mines last
+        qint64 sampleCount = 0;
+        QVector<qint64> mineTallies;
+
+        // the same for the batch of sweeps in progress
+        int batchSweeps = 0;
+        qint64 batchSampleCount = 0;
+        QVector<qint64> batchTallies;
+        // the chances each finished batch found, summed and squared, so the error bars don't need every batch kept around
+        int batchCount = 0;
+        QVector<double> batchChanceSums;
+        QVector<double> batchChanceSquares;
+    };
+
+    static void runChain(Chain& chain, const MineSampler* sampler, int sweeps, const CancellationToken* token);
+    // raises the penalty when the chain hasn't been legal lately and lowers it when it's legal so often it can't wander
+    // the penalty only changes during burn in, the tallies after that all come from the same chain
+    static void tunePenalty(Chain& chain);
+    // tallies the chain's minefield if it's legal, and finishes the batch once it has all its sweeps
+    void tally(Chain& chain) const;
+
+    // the unknowns around the count cell and some count cells near it, chosen by the chain's draws alone
+    void buildBlock(Chain& chain, int countCell, QVector<int>& block, QVector<int>& blockCountCells) const;
+    // redraws the block's cells from every state they could take, weighted by the rest of the chain's minefield
+    void updateBlock(Chain& chain, const QVector<int>& block, QVector<double>& logWeights) const;
+    // the ways to fill the tail path around the chain's minefield, less the penalty for the counts it misses
+    double logWeight(const Chain& chain) const;
+
+    // flips the cell and keeps the chain's counts and violation up to date
+    void flip(Chain& chain, int cell) const;
+
+    // the average of the chance each chain has tallied for the cell, the tail path's being the index after the path's
+    // the error is the largest of what the chains' disagreement, the batches' disagreement, and a sample per batch would give
+    // with only a few chains they can agree by luck, while the batches of a chain can be too alike, so neither is enough alone
+    void estimate(int index, double& chance, double& error) const;
+    double chanceScale(int index) const;
+
+    int tailPathCellCount = 0;
+    int mineCount = 0;
+
+    // the count cells next to each path cell, and the mines each count cell still needs
+    QVector<QVector<int>> cellCountCells;
+    QVector<int> countCellTargets;
+    // the path cells next to each count cell, and the count cells that share one with it
+    QVector<QVector<int>> countCellUnknowns;
+    QVector<QVector<int>> countCellNeighbors;
+
+    // the log of the ways to place each number of mines in the tail path
+    QVector<double> logTailWays;
+
+    QVector<Chain> chains;
+};
+
+#endif // MINESAMPLER_H
@@ -1,6 +1,8 @@
 #include "ObviousCellFlagger.h"
 #include "Minefield.h"
 
+#include <algorithm>
+
 ObviousCellFlagger::ObviousCellFlagger(const SolverMinefield &minefield)
     : minefield(minefield)
 {
@@ -14,46 +16,72 @@ const QHash<Coordinate, double> &ObviousCellFlagger::getChancesToBeMine() const
 
 void ObviousCellFlagger::flagObviousCells()
 {
-    int previousKnownCount = -1;
+    // every count cell gets looked at once, after that only the ones around newly flagged cells do
+    dirty.fill(false, minefield.getWidth() * minefield.getHeight());
+
+    minefield.traverseCells([&] (int x, int y) -> void {markDirty(x, y);});
 
-    while(previousKnownCount != chancesToBeMine.count())
+    while(!dirtyCountCells.isEmpty())
     {
-        previousKnownCount = chancesToBeMine.count();
+        Coordinate coord = dirtyCountCells.pop();
+        dirty[coord.first + coord.second * minefield.getWidth()] = false;
 
-        for(int x = 0; x < minefield.getWidth(); ++x)
-        {
-            for(int y = 0; y < minefield.getHeight(); ++y)
-            {
-                flagObviousAdjacents(x, y);
-            }
-        }
+        flagObviousAdjacents(coord.first, coord.second);
+        flagOverlappingCountCells(coord.first, coord.second);
     }
 }
 
-void ObviousCellFlagger::flagObviousAdjacents(int x, int y)
+void ObviousCellFlagger::markDirty(int x, int y)
 {
-    auto markAdjacentAsMines = [&] (int x, int y)
+    int index = x + y * minefield.getWidth();
+
+    if(minefield.getCell(x, y) >= 0 && !dirty[index])
     {
+        dirty[index] = true;
+        dirtyCountCells.push({x, y});
+    }
+}
+
+void ObviousCellFlagger::flagCell(int x, int y, bool mine)
+{
+    MineStatus status = minefield.getCell(x, y);
+
+    if(status < 0 && status != SpecialStatus::Visited)
+    {// unknown, unvisited cell, the minefield is updated in place rather than copied for every flag
+        mine? minefield.markMine(x, y) : minefield.markClear(x, y);
+
+        chancesToBeMine.insert({x, y}, mine? 1 : 0);
+
+        minefield.traverseAdjacentCells(x, y, [&] (int x, int y) -> void {markDirty(x, y);});
+    }
+}
+
+CoordVector ObviousCellFlagger::adjacentUnknowns(int x, int y) const
+{
+    CoordVector unknowns;
+
+    minefield.traverseAdjacentCells(x, y, [&] (int x, int y) -> void {
         MineStatus status = minefield.getCell(x, y);
 
         if(status < 0 && status != SpecialStatus::Visited)
-        {// unknown, unvisited cell, mark it mine
-            minefield = minefield.chooseMine(x, y);
-
-            chancesToBeMine.insert({x, y}, 1);
+        {
+            unknowns.append({x, y});
         }
+    });
+
+    return unknowns;
+}
+
+void ObviousCellFlagger::flagObviousAdjacents(int x, int y)
+{
+    auto markAdjacentAsMines = [&] (int x, int y)
+    {
+        flagCell(x, y, true);
     };
 
     auto markAdjacentAsClear = [&] (int x, int y)
     {
-        MineStatus status = minefield.getCell(x, y);
-
-        if(status < 0 && status != SpecialStatus::Visited)
-        {// unknown, unvisited cell, mark it clear
-            minefield = minefield.chooseClear(x, y);
-
-            chancesToBeMine.insert({x, y}, 0);
-        }
+        flagCell(x, y, false);
     };
 
     MineStatus status = minefield.getCell(x, y);
@@ -67,3 +95,97 @@ void ObviousCellFlagger::flagObviousAdjacents(int x, int y)
         minefield.traverseAdjacentCells(x, y, markAdjacentAsClear);
     }
 }
+
+void ObviousCellFlagger::flagOverlappingCountCells(int x, int y)
+{
+    MineStatus status = minefield.getCell(x, y);
+
+    if(status < 0)
+    {
+        return;
+    }
+
+    CoordVector unknowns = adjacentUnknowns(x, y);
+
+    if(unknowns.isEmpty())
+    {
+        return;
+    }
+
+    // the count cells sharing unknowns with this one are at most two cells away
+    for(int otherX = x - 2; otherX <= x + 2; ++otherX)
+    {
+        for(int otherY = y - 2; otherY <= y + 2; ++otherY)
+        {
+            if((otherX == x && otherY == y) || !minefield.checkBounds(otherX, otherY))
+            {
+                continue;
+            }
+
+            MineStatus otherStatus = minefield.getCell(otherX, otherY);
+
+            if(otherStatus < 0)
+            {
+                continue;
+            }
+
+            CoordVector otherUnknowns = adjacentUnknowns(otherX, otherY);
+
+            int shared = 0;
+
+            for(const Coordinate& coord : otherUnknowns)
+            {
+                unknowns.contains(coord)? ++shared : 0;
+            }
+
+            if(shared == 0)
+            {
+                continue;
+            }
+
+            int onlyHere = unknowns.size() - shared;
+            int onlyThere = otherUnknowns.size() - shared;
+
+            // the shared unknowns hold a number of mines both counts agree on
+            // each count's own unknowns then hold whatever of its count the shared ones don't
+            int leastShared = std::max({0, status - onlyHere, otherStatus - onlyThere});
+            int mostShared = std::min({shared, static_cast<int>(status), static_cast<int>(otherStatus)});
+
+            if(leastShared > mostShared)
+            {// a contradiction, the solver will find there are no legal minefields
+                return;
+            }
+
+            auto flagOwnUnknowns = [&] (const CoordVector& ownUnknowns, const CoordVector& otherUnknowns, int count, int onlyOwn) {
+                if(onlyOwn == 0)
+                {
+                    return false;
+                }
+
+                bool mine = count - mostShared == onlyOwn;
+
+                if(!mine && count - leastShared != 0)
+                {// the own unknowns can go either way
+                    return false;
+                }
+
+                for(const Coordinate& coord : ownUnknowns)
+                {
+                    if(!otherUnknowns.contains(coord))
+                    {
+                        flagCell(coord.first, coord.second, mine);
+                    }
+                }
+
+                return true;
+            };
+
+            flagOwnUnknowns(otherUnknowns, unknowns, otherStatus, onlyThere);
+
+            if(flagOwnUnknowns(unknowns, otherUnknowns, status, onlyHere))
+            {// this count cell's unknowns changed so it's dirty again and gets another look with them
+                return;
+            }
+        }
+    }
+}
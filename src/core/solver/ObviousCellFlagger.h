@@ -4,8 +4,11 @@
 #include "SolverMinefield.h"
 
 #include <QHash>
+#include <QStack>
+#include <QVector>
 
 typedef QPair<int, int> Coordinate;
+typedef QVector<Coordinate> CoordVector;
 
 class ObviousCellFlagger
 {
@@ -21,7 +24,18 @@ private:
 
     QHash<Coordinate, double> chancesToBeMine;
 
+    // count cells that need another look because one of their unknowns was flagged
+    QStack<Coordinate> dirtyCountCells;
+    QVector<bool> dirty;
+
+    void markDirty(int x, int y);
+    void flagCell(int x, int y, bool mine);
+
+    CoordVector adjacentUnknowns(int x, int y) const;
+
     void flagObviousAdjacents(int x, int y);
+    // compares the count cell with every count cell it shares unknowns with, as in the 1-1 and 1-2 patterns
+    void flagOverlappingCountCells(int x, int y);
 };
 
 #endif // OBVIOUSCELLFLAGGER_H
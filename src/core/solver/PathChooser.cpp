@@ -3,6 +3,13 @@
 #include "SolverMinefield.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <tuple>
 
 PathChooser::PathChooser(const SolverMinefield &minefield)
     : minefield(minefield)
@@ -41,7 +48,23 @@ void PathChooser::decidePath()
         }
     }
 
-    optimizePath();
+    // each region is ordered on its own and the regions are visited one after another
+    // each gets the share of the search's limits that its cells are of the path, so the first big region can't use them all up
+    qint64 cellCount = path.size();
+
+    regions = groupIndependentRegions(path);
+    path.clear();
+
+    for(CoordVector& region : regions)
+    {
+        int regionExpansionLimit = expansionLimit < 0? -1 : expansionLimit * region.size() / cellCount;
+        int regionTimeBudget = timeBudget < 0? -1 : timeBudget * region.size() / cellCount;
+
+        region = optimizePath(region, regionExpansionLimit, regionTimeBudget);
+        path.append(region);
+    }
+
+    regionCount = regions.size();
 }
 
 int PathChooser::countAdjacentCountCells(int x, int y) const
@@ -53,76 +76,368 @@ int PathChooser::countAdjacentCountCells(int x, int y) const
     return countCells;
 }
 
-void PathChooser::optimizePath()
+// the visited sets of partial paths are told apart by xoring a key per cell
+static quint64 cellKey(int cell)
 {
-    // this optimizer greedily chooses cells that have the highest number of influenced count cells that are already influenced by the path
-    // in other words it prefers to visit all unknowns around cells that are adjacent to the path
-    // this seems to give more consistent results than just running along rows/columns
-    auto pathSources = path;
-    path.clear();
+    quint64 key = quint64(cell + 1) * Q_UINT64_C(0x9e3779b97f4a7c15);
+    key = (key ^ (key >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    key = (key ^ (key >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
 
-    QHash<Coordinate, int> influencedCells;
+    return key ^ (key >> 31);
+}
 
-    auto traverseAdjacentCountCells = [&] (int x, int y, std::function<void(int, int)> func) {
-        minefield.traverseAdjacentCells(x, y, [&] (int countCellX, int countCellY) -> void { if(minefield.getCell(countCellX, countCellY) >= 0) func(countCellX, countCellY); });
-    };
+CoordVector PathChooser::optimizePath(const CoordVector &region, int regionExpansionLimit, int regionTimeBudget)
+{
+    // the graph's columns have a node for each way the mines so far can be spread over the count cells the path is partway through
+    // for a count cell that needs c more mines with k of its u unknowns visited, the visited ones hold between max(0, c - (u - k)) and min(c, k) of them
+    // so a column's size is predicted as the product of those ranges, it's an upper bound since it ignores count cells constraining each other
+    // the search keeps the partial paths with the smallest peak prediction and extends them with the cells around the count cells they're partway through
+    RegionIndex index = indexRegion(region);
+
+    PartialPath start;
+    start.visited.fill(false, region.size());
+    start.visitedAround.fill(0, index.countCellUnknowns.size());
+
+    QList<PartialPath> beam;
+    beam.append(start);
+
+    int expansions = 0;
+
+    QElapsedTimer searchTimer;
+    searchTimer.start();
+
+    // a beam of one is the greedy walk, which the queue does much faster
+    while(beamWidth > 1 && beam.first().order.size() < region.size()
+          && (regionExpansionLimit < 0 || expansions < regionExpansionLimit)
+          && (regionTimeBudget < 0 || searchTimer.elapsed() < regionTimeBudget))
+    {
+        beam = extendBeam(index, beam, expansions);
+    }
+
+    // once the search is out of expansions or time the rest is done greedily
+    PartialPath best = beam.first();
+    finishPathGreedily(index, best);
+
+    if(beamWidth > 1)
+    {// the beam judges cells by the peak so far, which can lead it somewhere the greedy walk avoids, so the walk gets a turn too
+        PartialPath greedy = start;
+        finishPathGreedily(index, greedy);
+
+        if(std::tie(greedy.peak, greedy.total) < std::tie(best.peak, best.total))
+        {
+            best = greedy;
+        }
+    }
+
+    predictedLogColumnSize = qMax(predictedLogColumnSize, best.peak);
+
+    CoordVector orderedRegion;
+
+    for(int cell : best.order)
+    {
+        orderedRegion.append(region[cell]);
+    }
+
+    return orderedRegion;
+}
+
+PathChooser::RegionIndex PathChooser::indexRegion(const CoordVector &region) const
+{
+    RegionIndex index;
+    index.adjacentCountCells.resize(region.size());
+
+    QHash<Coordinate, int> countCellIndices;
+    QVector<int> countCellMines;
+
+    for(int i = 0; i < region.size(); ++i)
+    {
+        minefield.traverseAdjacentCells(region[i].first, region[i].second, [&] (int x, int y) -> void {
+            if(minefield.getCell(x, y) < 0)
+            {
+                return;
+            }
 
-    auto countAlreadyInfluencedByPath = [&] (int x, int y) {
-        int influencedByPath = 0;
+            int countCell = countCellIndices.value({x, y}, -1);
 
-        traverseAdjacentCountCells(x, y, [&] (int countCellX, int countCellY) -> void {
-            if(influencedCells.contains({countCellX, countCellY}))
+            if(countCell < 0)
             {
-                ++influencedByPath;
+                countCell = index.countCellUnknowns.size();
+                countCellIndices.insert({x, y}, countCell);
+                index.countCellUnknowns.append(QVector<int>());
+                countCellMines.append(minefield.getCell(x, y));
             }
+
+            index.adjacentCountCells[i].append(countCell);
+            // every unknown next to a count cell is in the path, and in this region since the count cell links them
+            index.countCellUnknowns[countCell].append(i);
         });
+    }
 
-        return influencedByPath;
-    };
+    // the range is 1 before and after the path passes a count cell, so those add nothing
+    index.rangeBits.resize(index.countCellUnknowns.size());
 
-    auto updateInfluencedCells = [&] (int x, int y) {
-        traverseAdjacentCountCells(x, y, [&] (int countCellX, int countCellY) -> void {
-            Coordinate coord(countCellX, countCellY);
+    for(int countCell = 0; countCell < index.countCellUnknowns.size(); ++countCell)
+    {
+        int mines = countCellMines[countCell];
+        int unknowns = index.countCellUnknowns[countCell].size();
 
-            if(influencedCells.contains(coord))
+        for(int visited = 0; visited <= unknowns; ++visited)
+        {
+            int range = qMin(mines, visited) - qMax(0, mines - (unknowns - visited)) + 1;
+
+            index.rangeBits[countCell].append(std::log2(qMax(range, 1)));
+        }
+    }
+
+    return index;
+}
+
+double PathChooser::widthChange(const RegionIndex &index, const PartialPath &partialPath, int cell) const
+{
+    double change = 0;
+
+    for(int countCell : index.adjacentCountCells[cell])
+    {
+        int visited = partialPath.visitedAround[countCell];
+
+        change += index.rangeBits[countCell][visited + 1] - index.rangeBits[countCell][visited];
+    }
+
+    return change;
+}
+
+void PathChooser::extendPath(const RegionIndex &index, PartialPath &partialPath, int cell) const
+{
+    partialPath.width += widthChange(index, partialPath, cell);
+    partialPath.peak = qMax(partialPath.peak, partialPath.width);
+    partialPath.total += partialPath.width;
+    partialPath.visitedHash ^= cellKey(cell);
+
+    partialPath.order.append(cell);
+    partialPath.visited[cell] = true;
+
+    for(int countCell : index.adjacentCountCells[cell])
+    {
+        int visited = ++partialPath.visitedAround[countCell];
+        int unknowns = index.countCellUnknowns[countCell].size();
+
+        if(visited == 1 && unknowns > 1)
+        {
+            partialPath.fringe.append(countCell);
+        }
+        else if(visited == unknowns && unknowns > 1)
+        {// all of its unknowns are visited, so it's closed
+            partialPath.fringe.removeOne(countCell);
+        }
+    }
+}
+
+QList<PathChooser::PartialPath> PathChooser::extendBeam(const RegionIndex &index, const QList<PartialPath> &beam, int &expansions) const
+{
+    QVector<PathExtension> extensions;
+
+    for(int p = 0; p < beam.size(); ++p)
+    {
+        const PartialPath& partialPath = beam[p];
+        int extensionsBefore = extensions.size();
+
+        auto offer = [&] (int cell) {
+            double width = partialPath.width + widthChange(index, partialPath, cell);
+
+            extensions.append({p, cell, width, qMax(partialPath.peak, width), partialPath.total + width, partialPath.visitedHash ^ cellKey(cell)});
+        };
+
+        for(int countCell : partialPath.fringe)
+        {
+            for(int cell : index.countCellUnknowns[countCell])
             {
-                // -1 because we're going to visit another one of its adjacent unknowns
-                influencedCells.insert(coord, influencedCells[coord] - 1);
+                bool offered = partialPath.visited[cell];
+
+                for(int i = extensionsBefore; i < extensions.size() && !offered; ++i)
+                {// it may have been offered through another count cell
+                    offered = extensions[i].cell == cell;
+                }
+
+                if(!offered)
+                {
+                    offer(cell);
+                }
             }
-            else
+        }
+
+        if(partialPath.fringe.isEmpty())
+        {// nothing is partway through, which only happens at the start since the region is connected, so any cell can start it
+            for(int cell = 0; cell < partialPath.visited.size(); ++cell)
             {
-                // -1 because we're visiting the first of its adjacent unknowns
-                influencedCells.insert(coord, minefield.countAdjacentUnknowns(countCellX, countCellY) - 1);
+                offer(cell);
             }
+        }
+    }
+
+    expansions += extensions.size();
 
-            if(influencedCells[coord] <= 0)
-            {// no longer relevant to the path, all cells were visited
-                influencedCells.remove(coord);
+    std::sort(extensions.begin(), extensions.end(), [] (const PathExtension& a, const PathExtension& b) {
+        return std::tie(a.peak, a.width, a.total, a.partialPath, a.cell) < std::tie(b.peak, b.width, b.total, b.partialPath, b.cell);
+    });
+
+    QList<PartialPath> nextBeam;
+    QSet<quint64> keptVisitedSets;
+
+    for(const PathExtension& extension : extensions)
+    {
+        if(nextBeam.size() >= beamWidth)
+        {
+            break;
+        }
+
+        if(keptVisitedSets.contains(extension.visitedHash))
+        {// an order of the same cells with a better score is already kept, they all continue the same way from here
+            continue;
+        }
+
+        keptVisitedSets.insert(extension.visitedHash);
+
+        nextBeam.append(beam[extension.partialPath]);
+        extendPath(index, nextBeam.last(), extension.cell);
+    }
+
+    return nextBeam;
+}
+
+void PathChooser::finishPathGreedily(const RegionIndex &index, PartialPath &partialPath) const
+{
+    // a cell's score is whether it's off the fringe, then how much it would add to the width
+    // visiting a cell only changes the scores of the cells sharing a count cell with it, so only those are rescored and pushed again
+    // the stale entries left in the queue are skipped by their version when they come up
+    struct QueueEntry
+    {
+        bool offFringe;
+        double widthChange;
+        int cell;
+        int version;
+
+        bool operator>(const QueueEntry& other) const
+        {
+            return std::tie(offFringe, widthChange, cell) > std::tie(other.offFringe, other.widthChange, other.cell);
+        }
+    };
+
+    int cellCount = partialPath.visited.size();
+
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    QVector<int> versions(cellCount, 0);
+
+    auto score = [&] (int cell) {
+        bool offFringe = true;
+
+        for(int countCell : index.adjacentCountCells[cell])
+        {
+            int visited = partialPath.visitedAround[countCell];
+
+            if(visited > 0 && visited < index.countCellUnknowns[countCell].size())
+            {
+                offFringe = false;
             }
-        });
+        }
+
+        queue.push({offFringe, widthChange(index, partialPath, cell), cell, ++versions[cell]});
     };
 
-    while(!pathSources.isEmpty())
+    for(int cell = 0; cell < cellCount; ++cell)
+    {
+        if(!partialPath.visited[cell])
+        {
+            score(cell);
+        }
+    }
+
+    while(!queue.empty())
     {
-        int bestSourceIndex = 0;
-        int bestInfluencedInPathCount = 0;
+        QueueEntry entry = queue.top();
+        queue.pop();
 
-        for(int i = 0; i < pathSources.size(); ++i)
+        if(partialPath.visited[entry.cell] || entry.version != versions[entry.cell])
         {
-            auto coord = pathSources[i];
+            continue;
+        }
 
-            int influencedInPathCount = countAlreadyInfluencedByPath(coord.first, coord.second);
+        extendPath(index, partialPath, entry.cell);
 
-            if(influencedInPathCount < bestInfluencedInPathCount)
+        for(int countCell : index.adjacentCountCells[entry.cell])
+        {
+            for(int cell : index.countCellUnknowns[countCell])
             {
-                bestInfluencedInPathCount = influencedInPathCount;
-                bestSourceIndex = i;
+                if(!partialPath.visited[cell])
+                {
+                    score(cell);
+                }
             }
         }
+    }
+}
+
+QList<CoordVector> PathChooser::groupIndependentRegions(const CoordVector &cells) const
+{
+    // cells that share no count cell, directly or through other cells, can't affect each other except through the total mine count
+    // if the path finishes one region before starting the next, the fringe empties out in between
+    // so the graph's size is the sum of the regions' sizes instead of the product, and the mine counts carry across the single state in between
+    QVector<int> regions(cells.size());
 
-        path.append(pathSources.takeAt(bestSourceIndex));
-        updateInfluencedCells(path.last().first, path.last().second);
+    for(int i = 0; i < cells.size(); ++i)
+    {
+        regions[i] = i;
     }
+
+    auto findRegion = [&] (int i) {
+        while(regions[i] != i)
+        {// halve the way to the root as we go so later finds are quicker
+            regions[i] = regions[regions[i]];
+            i = regions[i];
+        }
+
+        return i;
+    };
+
+    // the first path cell seen next to each count cell, every other cell next to it joins that one's region
+    QHash<Coordinate, int> countCellRegions;
+
+    for(int i = 0; i < cells.size(); ++i)
+    {
+        minefield.traverseAdjacentCells(cells[i].first, cells[i].second, [&] (int x, int y) -> void {
+            if(minefield.getCell(x, y) < 0)
+            {
+                return;
+            }
+
+            if(!countCellRegions.contains({x, y}))
+            {
+                countCellRegions.insert({x, y}, i);
+            }
+            else
+            {
+                regions[findRegion(i)] = findRegion(countCellRegions[{x, y}]);
+            }
+        });
+    }
+
+    // the regions keep the order they're first reached in
+    QHash<int, int> regionIndices;
+    QList<CoordVector> regionCells;
+
+    for(int i = 0; i < cells.size(); ++i)
+    {
+        int region = findRegion(i);
+
+        if(!regionIndices.contains(region))
+        {
+            regionIndices.insert(region, regionCells.size());
+            regionCells.append(CoordVector());
+        }
+
+        regionCells[regionIndices[region]].append(cells[i]);
+    }
+
+    return regionCells;
 }
 
 const CoordVector &PathChooser::getPath() const
@@ -134,3 +449,33 @@ const CoordVector &PathChooser::getTailPath() const
 {
     return tailPath;
 }
+
+int PathChooser::getRegionCount() const
+{
+    return regionCount;
+}
+
+const QList<CoordVector> &PathChooser::getRegions() const
+{
+    return regions;
+}
+
+double PathChooser::getPredictedLogColumnSize() const
+{
+    return predictedLogColumnSize;
+}
+
+void PathChooser::setBeamWidth(int beamWidth)
+{
+    this->beamWidth = qMax(1, beamWidth);
+}
+
+void PathChooser::setExpansionLimit(int expansions)
+{
+    expansionLimit = expansions;
+}
+
+void PathChooser::setTimeBudget(int milliseconds)
+{
+    timeBudget = milliseconds;
+}
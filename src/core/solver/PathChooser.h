@@ -4,6 +4,7 @@
 #include "SolverMinefield.h"
 
 #include <QHash>
+#include <QList>
 #include <QPair>
 #include <QSharedPointer>
 #include <QVector>
@@ -16,6 +17,10 @@ typedef QVector<Coordinate> CoordVector;
 class PathChooser
 {
 public:
+    static const int DEFAULT_BEAM_WIDTH = 4;
+    // around 20ms of search on a hard board
+    static const int DEFAULT_EXPANSION_LIMIT = 100000;
+
     PathChooser(const SolverMinefield& minefield);
 
     void decidePath();
@@ -23,6 +28,23 @@ public:
     const CoordVector &getPath() const;
     const CoordVector &getTailPath() const;
 
+    // the number of independent regions the path visits one after another
+    int getRegionCount() const;
+    // the path split into its regions, each in the order the path visits it
+    const QList<CoordVector> &getRegions() const;
+
+    // the log2 of the largest column the path is predicted to need, an upper bound on the real size
+    double getPredictedLogColumnSize() const;
+
+    // the ordering search keeps this many partial paths at once, 1 makes it a plain greedy walk
+    void setBeamWidth(int beamWidth);
+    // once the search has scored this many ways to extend its partial paths it finishes greedily, a negative limit never runs out
+    // the limit is shared out between the regions by their cell counts, and it always stops the search at the same place for the same board
+    void setExpansionLimit(int expansions);
+    // once the search has taken this many milliseconds it finishes greedily, a negative budget never runs out
+    // the budget is shared out like the expansion limit, but where it stops depends on the machine, so the same board can get a different path
+    void setTimeBudget(int milliseconds);
+
 private:
     SolverMinefield minefield;
 
@@ -32,9 +54,71 @@ private:
     int width;
     int height;
 
+    QList<CoordVector> regions;
+    int regionCount = 0;
+
+    double predictedLogColumnSize = 0;
+
+    int beamWidth = DEFAULT_BEAM_WIDTH;
+    int expansionLimit = DEFAULT_EXPANSION_LIMIT;
+    int timeBudget = -1;
+
     int countAdjacentCountCells(int x, int y) const;
 
-    void optimizePath();
+    // the cells of a region and the count cells around them by dense index, so the search never looks anything up by coordinate
+    struct RegionIndex
+    {
+        QVector<QVector<int>> adjacentCountCells;
+        QVector<QVector<int>> countCellUnknowns;
+        // the log2 of the range of mines for each count cell and each number of its unknowns visited
+        QVector<QVector<double>> rangeBits;
+    };
+
+    // a path through part of a region as indices into the region, with what's needed to score the ways to extend it
+    struct PartialPath
+    {
+        QVector<int> order;
+        QVector<bool> visited;
+        // how many of each count cell's unknowns the path has visited
+        QVector<int> visitedAround;
+        // the count cells the path is partway through, only the cells around these are tried next
+        QVector<int> fringe;
+
+        // the log2 of the predicted column size after the last cell, the largest of those so far, and their sum
+        double width = 0;
+        double peak = 0;
+        double total = 0;
+
+        // identifies the set of visited cells so that two orders of the same cells aren't both kept
+        quint64 visitedHash = 0;
+    };
+
+    struct PathExtension
+    {
+        int partialPath = 0;
+        int cell = 0;
+
+        double width = 0;
+        double peak = 0;
+        double total = 0;
+
+        quint64 visitedHash = 0;
+    };
+
+    // orders the cells of one region to keep the predicted size of the graph's columns down
+    CoordVector optimizePath(const CoordVector& region, int regionExpansionLimit, int regionTimeBudget);
+    RegionIndex indexRegion(const CoordVector& region) const;
+
+    // how much visiting the cell would change the path's width
+    double widthChange(const RegionIndex& index, const PartialPath& partialPath, int cell) const;
+    void extendPath(const RegionIndex& index, PartialPath& partialPath, int cell) const;
+
+    // one step of the beam search, every partial path in the beam is one cell longer after it
+    // the extensions it scored are added to the count
+    QList<PartialPath> extendBeam(const RegionIndex& index, const QList<PartialPath>& beam, int& expansions) const;
+    // the rest of the path one best cell at a time, the cells' scores are kept in a priority queue and only the ones near each chosen cell are rescored
+    void finishPathGreedily(const RegionIndex& index, PartialPath& partialPath) const;
+    QList<CoordVector> groupIndependentRegions(const CoordVector& cells) const;
 };
 
 #endif // PATHCHOOSER_H
@@ -0,0 +1,393 @@
+#include "PathKernels.h"
+
+#include "SolverMath.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PATH_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+#if defined(PATH_KERNELS_X86) && defined(_MSC_VER) && !defined(__clang__)
+// msvc lets any function use the vector instructions, it only needs to check the cpu has them before calling it
+#include <intrin.h>
+#define AVX2_TARGET
+#define AVX512_TARGET
+#elif defined(PATH_KERNELS_X86)
+// gcc and clang compile only these functions for the wider instruction sets, the rest of the build stays portable
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define AVX512_TARGET __attribute__((target("avx512f")))
+#endif
+
+namespace PathKernels
+{
+#if defined(PATH_KERNELS_X86)
+enum class InstructionSet
+{
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+static InstructionSet detectInstructionSet()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int registers[4];
+
+    __cpuid(registers, 1);
+
+    // the os has to save the wider registers on a context switch too, which is what osxsave and xgetbv say
+    bool osSavesVectors = (registers[2] & (1 << 27)) != 0;
+
+    if(!osSavesVectors)
+    {
+        return InstructionSet::Scalar;
+    }
+
+    unsigned long long savedState = _xgetbv(0);
+
+    __cpuidex(registers, 7, 0);
+
+    if((registers[1] & (1 << 16)) && (savedState & 0xe6) == 0xe6)
+    {
+        return InstructionSet::Avx512;
+    }
+
+    if((registers[1] & (1 << 5)) && (savedState & 0x6) == 0x6)
+    {
+        return InstructionSet::Avx2;
+    }
+
+    return InstructionSet::Scalar;
+#else
+    // these check that the os saves the registers as well
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx512f"))
+    {
+        return InstructionSet::Avx512;
+    }
+
+    if(__builtin_cpu_supports("avx2"))
+    {
+        return InstructionSet::Avx2;
+    }
+
+    return InstructionSet::Scalar;
+#endif
+}
+
+// checked once, the first time a kernel runs
+static InstructionSet instructionSet()
+{
+    static const InstructionSet detected = detectInstructionSet();
+
+    return detected;
+}
+
+// each vector version does as many whole vectors as fit and returns where it stopped, the scalar loops finish the rest
+
+AVX512_TARGET static int scaledAddAvx512(double *target, const double *source, int count, double scale)
+{
+    int i = 0;
+    __m512d scaleVector = _mm512_set1_pd(scale);
+
+    for(; i + 8 <= count; i += 8)
+    {
+        __m512d sum = _mm512_add_pd(_mm512_loadu_pd(target + i), _mm512_mul_pd(_mm512_loadu_pd(source + i), scaleVector));
+        _mm512_storeu_pd(target + i, sum);
+    }
+
+    return i;
+}
+
+AVX2_TARGET static int scaledAddAvx2(double *target, const double *source, int count, double scale)
+{
+    int i = 0;
+    __m256d scaleVector = _mm256_set1_pd(scale);
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m256d sum = _mm256_add_pd(_mm256_loadu_pd(target + i), _mm256_mul_pd(_mm256_loadu_pd(source + i), scaleVector));
+        _mm256_storeu_pd(target + i, sum);
+    }
+
+    return i;
+}
+
+AVX512_TARGET static int scaleAvx512(double *values, int count, double factor)
+{
+    int i = 0;
+    __m512d factorVector = _mm512_set1_pd(factor);
+
+    for(; i + 8 <= count; i += 8)
+    {
+        _mm512_storeu_pd(values + i, _mm512_mul_pd(_mm512_loadu_pd(values + i), factorVector));
+    }
+
+    return i;
+}
+
+AVX2_TARGET static int scaleAvx2(double *values, int count, double factor)
+{
+    int i = 0;
+    __m256d factorVector = _mm256_set1_pd(factor);
+
+    for(; i + 4 <= count; i += 4)
+    {
+        _mm256_storeu_pd(values + i, _mm256_mul_pd(_mm256_loadu_pd(values + i), factorVector));
+    }
+
+    return i;
+}
+
+AVX512_TARGET static int rangeAvx512(const double *values, int count, double &largest, double &smallestNonZero)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    int i = 0;
+    __m512d largestVector = _mm512_setzero_pd();
+    __m512d smallestVector = _mm512_set1_pd(infinity);
+
+    for(; i + 8 <= count; i += 8)
+    {
+        __m512d value = _mm512_loadu_pd(values + i);
+        __mmask8 zeros = _mm512_cmp_pd_mask(value, _mm512_setzero_pd(), _CMP_EQ_OQ);
+
+        // gcc 12's headers give the unmasked max and min an undefined vector to pass through, which it then warns is uninitialized
+        // zero masking with every lane set is the same instruction without it
+        largestVector = _mm512_maskz_max_pd(0xff, largestVector, value);
+        smallestVector = _mm512_maskz_min_pd(0xff, smallestVector, _mm512_mask_blend_pd(zeros, value, _mm512_set1_pd(infinity)));
+    }
+
+    double largestLanes[8];
+    double smallestLanes[8];
+    _mm512_storeu_pd(largestLanes, largestVector);
+    _mm512_storeu_pd(smallestLanes, smallestVector);
+
+    for(int lane = 0; lane < 8; ++lane)
+    {
+        largest = std::max(largest, largestLanes[lane]);
+        smallestNonZero = std::min(smallestNonZero, smallestLanes[lane]);
+    }
+
+    return i;
+}
+
+AVX2_TARGET static int rangeAvx2(const double *values, int count, double &largest, double &smallestNonZero)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    int i = 0;
+    __m256d largestVector = _mm256_setzero_pd();
+    __m256d smallestVector = _mm256_set1_pd(infinity);
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m256d value = _mm256_loadu_pd(values + i);
+        __m256d zeros = _mm256_cmp_pd(value, _mm256_setzero_pd(), _CMP_EQ_OQ);
+
+        largestVector = _mm256_max_pd(largestVector, value);
+        smallestVector = _mm256_min_pd(smallestVector, _mm256_blendv_pd(value, _mm256_set1_pd(infinity), zeros));
+    }
+
+    double largestLanes[4];
+    double smallestLanes[4];
+    _mm256_storeu_pd(largestLanes, largestVector);
+    _mm256_storeu_pd(smallestLanes, smallestVector);
+
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        largest = std::max(largest, largestLanes[lane]);
+        smallestNonZero = std::min(smallestNonZero, smallestLanes[lane]);
+    }
+
+    return i;
+}
+
+// b is walked backward from its end, the vector versions load it forward and reverse the lanes
+AVX512_TARGET static int reversedDotAvx512(const double *a, const double *b, int count, double &sum)
+{
+    int i = 0;
+    __m512d sumVector = _mm512_setzero_pd();
+    const __m512i reverse = _mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+
+    for(; i + 8 <= count; i += 8)
+    {
+        // zero masked for the same reason as the max and min above
+        __m512d reversedB = _mm512_maskz_permutexvar_pd(0xff, reverse, _mm512_loadu_pd(b + count - i - 8));
+        sumVector = _mm512_add_pd(sumVector, _mm512_mul_pd(_mm512_loadu_pd(a + i), reversedB));
+    }
+
+    double lanes[8];
+    _mm512_storeu_pd(lanes, sumVector);
+
+    for(int lane = 0; lane < 8; ++lane)
+    {
+        sum += lanes[lane];
+    }
+
+    return i;
+}
+
+AVX2_TARGET static int reversedDotAvx2(const double *a, const double *b, int count, double &sum)
+{
+    int i = 0;
+    __m256d sumVector = _mm256_setzero_pd();
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m256d reversedB = _mm256_permute4x64_pd(_mm256_loadu_pd(b + count - i - 4), 0x1b);
+        sumVector = _mm256_add_pd(sumVector, _mm256_mul_pd(_mm256_loadu_pd(a + i), reversedB));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, sumVector);
+
+    for(int lane = 0; lane < 4; ++lane)
+    {
+        sum += lanes[lane];
+    }
+
+    return i;
+}
+#endif
+
+void scaledAdd(double *target, const double *source, int count, double scale)
+{
+    int i = 0;
+
+#if defined(PATH_KERNELS_X86)
+    switch(instructionSet())
+    {
+    case InstructionSet::Avx512:
+        i = scaledAddAvx512(target, source, count, scale);
+        break;
+    case InstructionSet::Avx2:
+        i = scaledAddAvx2(target, source, count, scale);
+        break;
+    default:
+        break;
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        target[i] += source[i] * scale;
+    }
+}
+
+void scale(double *values, int count, double factor)
+{
+    int i = 0;
+
+#if defined(PATH_KERNELS_X86)
+    switch(instructionSet())
+    {
+    case InstructionSet::Avx512:
+        i = scaleAvx512(values, count, factor);
+        break;
+    case InstructionSet::Avx2:
+        i = scaleAvx2(values, count, factor);
+        break;
+    default:
+        break;
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        values[i] *= factor;
+    }
+}
+
+void range(const double *values, int count, double &largest, double &smallestNonZero)
+{
+    // zeros are swapped for infinity when looking for the smallest so they never win
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    largest = 0;
+    smallestNonZero = infinity;
+
+    int i = 0;
+
+#if defined(PATH_KERNELS_X86)
+    switch(instructionSet())
+    {
+    case InstructionSet::Avx512:
+        i = rangeAvx512(values, count, largest, smallestNonZero);
+        break;
+    case InstructionSet::Avx2:
+        i = rangeAvx2(values, count, largest, smallestNonZero);
+        break;
+    default:
+        break;
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        largest = std::max(largest, values[i]);
+
+        if(values[i] != 0)
+        {
+            smallestNonZero = std::min(smallestNonZero, values[i]);
+        }
+    }
+
+    if(smallestNonZero == infinity)
+    {
+        smallestNonZero = 0;
+    }
+}
+
+double reversedDot(const double *a, const double *b, int count)
+{
+    double sum = 0;
+    int i = 0;
+
+#if defined(PATH_KERNELS_X86)
+    switch(instructionSet())
+    {
+    case InstructionSet::Avx512:
+        i = reversedDotAvx512(a, b, count, sum);
+        break;
+    case InstructionSet::Avx2:
+        i = reversedDotAvx2(a, b, count, sum);
+        break;
+    default:
+        break;
+    }
+#endif
+
+    for(; i < count; ++i)
+    {
+        sum += a[i] * b[count - 1 - i];
+    }
+
+    return sum;
+}
+
+void addModulo(quint64 *target, const quint64 *source, int count, quint64 modulus)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        target[i] = SolverMath::addModulo(target[i], source[i], modulus);
+    }
+}
+
+quint64 reversedDotModulo(const quint64 *a, const quint64 *b, int count, quint64 modulus)
+{
+    quint64 sum = 0;
+
+    for(int i = 0; i < count; ++i)
+    {
+        sum = SolverMath::addModulo(sum, SolverMath::multiplyModulo(a[i], b[count - 1 - i], modulus), modulus);
+    }
+
+    return sum;
+}
+
+}
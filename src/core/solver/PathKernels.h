@@ -0,0 +1,33 @@
+#ifndef PATHKERNELS_H
+#define PATHKERNELS_H
+
+// the inner loops of the path counting, over plain arrays of doubles so they vectorize
+// each has an AVX-512 and an AVX2 version picked by what the cpu supports when first called, and a scalar one otherwise
+// a column keeps its counts in one block, node after node, each node's mine count window contiguous inside it
+
+#include <QtGlobal>
+
+namespace PathKernels
+{
+// target[i] += source[i] * scale
+void scaledAdd(double *target, const double *source, int count, double scale);
+
+// values[i] *= factor
+void scale(double *values, int count, double factor);
+
+// finds the largest value and the smallest value that isn't zero, both are zero if every value is
+// path counts are never negative, so this doesn't bother with absolute values
+void range(const double *values, int count, double &largest, double &smallestNonZero);
+
+// the sum of a[i] * b[count - 1 - i], which pairs up paths back and forward that use a fixed total of mines
+double reversedDot(const double *a, const double *b, int count);
+
+// the same for exact counts modulo a prime, there's no vector instruction for the full 128 bit products so these are scalar
+// target[i] = (target[i] + source[i]) mod modulus
+void addModulo(quint64 *target, const quint64 *source, int count, quint64 modulus);
+
+// the sum of a[i] * b[count - 1 - i] mod modulus
+quint64 reversedDotModulo(const quint64 *a, const quint64 *b, int count, quint64 modulus);
+}
+
+#endif // PATHKERNELS_H
@@ -0,0 +1,18 @@
+#ifndef PATHNUMERICS_H
+#define PATHNUMERICS_H
+
+// how the solver stores the path counts of the solution graph
+enum class PathNumerics
+{
+    // scaled doubles, falling back to SolverFloat if some counts spread too widely for them
+    Automatic,
+    // doubles that share a power of two exponent per node, fast and small but with limited range within a node
+    ScaledDouble,
+    // every count is a SolverFloat, which has the range for any board but is a software float
+    BinFloat,
+    // the counts are found modulo several large primes, one pass over the graph per prime, and put back together exactly
+    // several times slower, but the chances are the exact ratios rounded once to a double, which is what audits need
+    Exact
+};
+
+#endif // PATHNUMERICS_H
@@ -0,0 +1,109 @@
+#include "RegionCache.h"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+QByteArray RegionCache::regionKey(const SolverMinefield &minefield, const CoordVector &region)
+{
+    CoordVector cells = region;
+    CoordVector countCells;
+
+    for(const Coordinate& cell : region)
+    {
+        minefield.traverseAdjacentCells(cell.first, cell.second, [&] (int x, int y) -> void {
+            if(minefield.getCell(x, y) >= 0)
+            {
+                countCells.append({x, y});
+            }
+        });
+    }
+
+    // the path may visit the same cells in another order, the key shouldn't care
+    std::sort(cells.begin(), cells.end());
+    std::sort(countCells.begin(), countCells.end());
+    countCells.erase(std::unique(countCells.begin(), countCells.end()), countCells.end());
+
+    QByteArray key;
+
+    auto appendNumber = [&] (int number) {
+        key.append(reinterpret_cast<const char*>(&number), sizeof(number));
+    };
+
+    appendNumber(cells.size());
+
+    for(const Coordinate& cell : cells)
+    {
+        appendNumber(cell.first);
+        appendNumber(cell.second);
+    }
+
+    for(const Coordinate& countCell : countCells)
+    {
+        appendNumber(countCell.first);
+        appendNumber(countCell.second);
+        appendNumber(minefield.getCell(countCell.first, countCell.second));
+    }
+
+    return key;
+}
+
+QSharedPointer<const RegionDistribution> RegionCache::find(const QByteArray &key) const
+{
+    QMutexLocker locker(&mutex);
+
+    return distributions.value(key);
+}
+
+void RegionCache::insert(const QByteArray &key, QSharedPointer<const RegionDistribution> distribution)
+{
+    QMutexLocker locker(&mutex);
+
+    distributions.insert(key, distribution);
+}
+
+void RegionCache::retain(const QSet<QByteArray> &keys)
+{
+    QMutexLocker locker(&mutex);
+
+    for(auto iter = distributions.begin(); iter != distributions.end();)
+    {
+        bool held = keys.contains(iter.key());
+
+        for(const QSet<QByteArray> &holderKeys : heldKeys)
+        {
+            held = held || holderKeys.contains(iter.key());
+        }
+
+        if(held)
+        {
+            ++iter;
+        }
+        else
+        {
+            iter = distributions.erase(iter);
+        }
+    }
+}
+
+void RegionCache::hold(const void *holder, const QSet<QByteArray> &keys)
+{
+    QMutexLocker locker(&mutex);
+
+    heldKeys.insert(holder, keys);
+}
+
+void RegionCache::release(const void *holder)
+{
+    QMutexLocker locker(&mutex);
+
+    // the regions stay until the next retain, which is when the live board says what it still needs
+    heldKeys.remove(holder);
+}
+
+int RegionCache::size() const
+{
+    QMutexLocker locker(&mutex);
+
+    return distributions.size();
+}
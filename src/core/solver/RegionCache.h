@@ -0,0 +1,58 @@
+#ifndef REGIONCACHE_H
+#define REGIONCACHE_H
+
+#include "SolverFloat.h"
+#include "SolverMinefield.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QSharedPointer>
+#include <QVector>
+
+typedef QPair<int, int> Coordinate;
+typedef QVector<Coordinate> CoordVector;
+
+// what an independent region of the path contributes to a solve, none of it depends on anything outside the region
+struct RegionDistribution
+{
+    // the ways to place mines in the region's cells, entry i places i mines
+    QVector<SolverFloat> ways;
+    // the same for each cell of the region, only counting the ways where that cell is a mine
+    QHash<Coordinate, QVector<SolverFloat>> waysToBeMine;
+    // the sizes of the region's columns
+    QHash<Coordinate, int> columnCounts;
+};
+
+// keeps the distributions of the regions of a board from one solve to the next
+// a reveal usually only changes a region or two, so the next solve only has to solve those and combine them with the rest
+// solves on different threads can share a cache
+class RegionCache
+{
+public:
+    // covers the region's cells and the remaining counts of the count cells around them, which is everything its distribution depends on
+    static QByteArray regionKey(const SolverMinefield& minefield, const CoordVector& region);
+
+    QSharedPointer<const RegionDistribution> find(const QByteArray& key) const;
+    void insert(const QByteArray& key, QSharedPointer<const RegionDistribution> distribution);
+
+    // forgets every region but these and the ones held, so the cache doesn't grow past the regions of the latest solve
+    void retain(const QSet<QByteArray>& keys);
+
+    // a speculative solve holds on to its regions instead, which leaves everyone else's alone
+    // they're kept through any retain until the holder releases them, since the next board may be the one it solved
+    void hold(const void *holder, const QSet<QByteArray>& keys);
+    void release(const void *holder);
+
+    int size() const;
+
+private:
+    mutable QMutex mutex;
+
+    QHash<QByteArray, QSharedPointer<const RegionDistribution>> distributions;
+    QHash<const void*, QSet<QByteArray>> heldKeys;
+};
+
+#endif // REGIONCACHE_H
@@ -0,0 +1,199 @@
+#include "SolutionCache.h"
+
+#include <QMutexLocker>
+
+SolutionCache::SolutionCache(qsizetype maxBytes)
+    : solutions(maxBytes)
+{
+}
+
+QSharedPointer<CachedSolution> SolutionCache::find(const SolverMinefield &minefield, int mineCount, bool populated) const
+{
+    Symmetry symmetry;
+    QByteArray key = canonicalKey(minefield, mineCount, populated, symmetry);
+
+    QMutexLocker locker(&mutex);
+
+    const CachedSolution *cachedSolution = solutions.object(key);
+
+    if(!cachedSolution)
+    {
+        return {};
+    }
+
+    return QSharedPointer<CachedSolution>(mapSolution(*cachedSolution, [&] (const Coordinate& coord) {
+        return fromCanonical(symmetry, coord, minefield.getWidth(), minefield.getHeight());
+    }));
+}
+
+void SolutionCache::insert(const SolverMinefield &minefield, int mineCount, bool populated, const CachedSolution &solution)
+{
+    Symmetry symmetry;
+    QByteArray key = canonicalKey(minefield, mineCount, populated, symmetry);
+
+    CachedSolution *cachedSolution = mapSolution(solution, [&] (const Coordinate& coord) {
+        return toCanonical(symmetry, coord, minefield.getWidth(), minefield.getHeight());
+    });
+
+    // a hash entry holds its key and value along with a couple of pointers of bookkeeping
+    qsizetype cost = key.size() + sizeof(CachedSolution) + cachedSolution->path.size() * sizeof(Coordinate)
+            + cachedSolution->chancesToBeMine.size() * (sizeof(Coordinate) + sizeof(double) + 2 * sizeof(void*))
+            + cachedSolution->columnCounts.size() * (sizeof(Coordinate) + sizeof(int) + 2 * sizeof(void*));
+
+    QMutexLocker locker(&mutex);
+
+    // the cache takes ownership, and deletes it right away if it's larger than the whole cache
+    solutions.insert(key, cachedSolution, cost);
+}
+
+void SolutionCache::setCanonicalizeSymmetries(bool canonicalize)
+{
+    QMutexLocker locker(&mutex);
+
+    if(canonicalize != canonicalizeSymmetries)
+    {// the keys change, so nothing stored so far can be found anymore
+        canonicalizeSymmetries = canonicalize;
+
+        solutions.clear();
+    }
+}
+
+void SolutionCache::setMaxBytes(qsizetype maxBytes)
+{
+    QMutexLocker locker(&mutex);
+
+    solutions.setMaxCost(maxBytes);
+}
+
+qsizetype SolutionCache::getMaxBytes() const
+{
+    QMutexLocker locker(&mutex);
+
+    return solutions.maxCost();
+}
+
+int SolutionCache::size() const
+{
+    QMutexLocker locker(&mutex);
+
+    return solutions.size();
+}
+
+void SolutionCache::clear()
+{
+    QMutexLocker locker(&mutex);
+
+    solutions.clear();
+}
+
+Coordinate SolutionCache::toCanonical(const Symmetry &symmetry, const Coordinate &coord, int width, int height)
+{
+    if(coord.first < 0 || coord.second < 0)
+    {
+        return coord;
+    }
+
+    int x = symmetry.flipX? width - 1 - coord.first : coord.first;
+    int y = symmetry.flipY? height - 1 - coord.second : coord.second;
+
+    return symmetry.transpose? Coordinate{y, x} : Coordinate{x, y};
+}
+
+Coordinate SolutionCache::fromCanonical(const Symmetry &symmetry, const Coordinate &coord, int width, int height)
+{
+    if(coord.first < 0 || coord.second < 0)
+    {
+        return coord;
+    }
+
+    int x = symmetry.transpose? coord.second : coord.first;
+    int y = symmetry.transpose? coord.first : coord.second;
+
+    return {symmetry.flipX? width - 1 - x : x, symmetry.flipY? height - 1 - y : y};
+}
+
+CachedSolution *SolutionCache::mapSolution(const CachedSolution &solution, const std::function<Coordinate (const Coordinate &)> &mapCoordinate)
+{
+    CachedSolution *mappedSolution = new CachedSolution;
+
+    mappedSolution->legalFieldCount = solution.legalFieldCount;
+
+    for(auto iter = solution.chancesToBeMine.constBegin(); iter != solution.chancesToBeMine.constEnd(); ++iter)
+    {
+        mappedSolution->chancesToBeMine.insert(mapCoordinate(iter.key()), iter.value());
+    }
+
+    for(const Coordinate &coord : solution.path)
+    {
+        mappedSolution->path.append(mapCoordinate(coord));
+    }
+
+    for(auto iter = solution.columnCounts.constBegin(); iter != solution.columnCounts.constEnd(); ++iter)
+    {
+        mappedSolution->columnCounts.insert(mapCoordinate(iter.key()), iter.value());
+    }
+
+    return mappedSolution;
+}
+
+QByteArray SolutionCache::boardKey(const SolverMinefield &minefield, int mineCount, bool populated, const Symmetry &symmetry)
+{
+    int width = minefield.getWidth();
+    int height = minefield.getHeight();
+
+    int canonicalWidth = symmetry.transpose? height : width;
+    int canonicalHeight = symmetry.transpose? width : height;
+
+    QByteArray key;
+    key.reserve(3 * sizeof(int) + 1 + width * height);
+
+    for(int number : {canonicalWidth, canonicalHeight, mineCount})
+    {
+        key.append(reinterpret_cast<const char*>(&number), sizeof(number));
+    }
+
+    key.append(static_cast<char>(populated));
+
+    // the cells in the order the canonical board lays them out, so every symmetry's key can be compared with the others
+    for(int y = 0; y < canonicalHeight; ++y)
+    {
+        for(int x = 0; x < canonicalWidth; ++x)
+        {
+            Coordinate cell = fromCanonical(symmetry, {x, y}, width, height);
+
+            key.append(minefield.getCell(cell.first, cell.second));
+        }
+    }
+
+    return key;
+}
+
+QByteArray SolutionCache::canonicalKey(const SolverMinefield &minefield, int mineCount, bool populated, Symmetry &symmetry) const
+{
+    symmetry = Symmetry();
+
+    QByteArray key = boardKey(minefield, mineCount, populated, symmetry);
+
+    {
+        QMutexLocker locker(&mutex);
+
+        if(!canonicalizeSymmetries)
+        {
+            return key;
+        }
+    }
+
+    for(int i = 1; i < 8; ++i)
+    {
+        Symmetry candidate{(i & 1) != 0, (i & 2) != 0, (i & 4) != 0};
+        QByteArray candidateKey = boardKey(minefield, mineCount, populated, candidate);
+
+        if(candidateKey < key)
+        {
+            key = candidateKey;
+            symmetry = candidate;
+        }
+    }
+
+    return key;
+}
@@ -0,0 +1,81 @@
+#ifndef SOLUTIONCACHE_H
+#define SOLUTIONCACHE_H
+
+#include "SolverFloat.h"
+#include "SolverMinefield.h"
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSharedPointer>
+#include <QVector>
+
+#include <functional>
+
+typedef QPair<int, int> Coordinate;
+typedef QVector<Coordinate> CoordVector;
+
+// the results of a solve, which is all a later solve of the same board needs
+struct CachedSolution
+{
+    QHash<Coordinate, double> chancesToBeMine;
+    SolverFloat legalFieldCount = 0;
+
+    // kept so a cached solve still shows how it was solved
+    CoordVector path;
+    QHash<Coordinate, int> columnCounts;
+};
+
+// remembers the solutions of whole boards, so a board that comes up again is answered without building a graph
+// the least recently used solutions are dropped once they take up more than the cache's size
+// solves on different threads can share a cache
+class SolutionCache
+{
+public:
+    static const qsizetype DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+    explicit SolutionCache(qsizetype maxBytes = DEFAULT_MAX_BYTES);
+
+    // a board is looked up by its cells after every known mine and clear cell is marked, its size, the mines left, and if it's populated yet
+    // the solution is in the board's coordinates, or null if it isn't cached
+    QSharedPointer<CachedSolution> find(const SolverMinefield& minefield, int mineCount, bool populated) const;
+    void insert(const SolverMinefield& minefield, int mineCount, bool populated, const CachedSolution& solution);
+
+    // with this set, boards that are rotations or reflections of each other share a solution
+    void setCanonicalizeSymmetries(bool canonicalize);
+
+    void setMaxBytes(qsizetype maxBytes);
+    qsizetype getMaxBytes() const;
+
+    int size() const;
+    void clear();
+
+private:
+    // the eight ways to lay a board back onto a grid, the flips happen before the transpose
+    struct Symmetry
+    {
+        bool flipX = false;
+        bool flipY = false;
+        bool transpose = false;
+    };
+
+    // coordinates off the board, like the final column's, are left as they are
+    static Coordinate toCanonical(const Symmetry& symmetry, const Coordinate& coord, int width, int height);
+    static Coordinate fromCanonical(const Symmetry& symmetry, const Coordinate& coord, int width, int height);
+    static CachedSolution *mapSolution(const CachedSolution& solution, const std::function<Coordinate(const Coordinate&)>& mapCoordinate);
+
+    static QByteArray boardKey(const SolverMinefield& minefield, int mineCount, bool populated, const Symmetry& symmetry);
+    // the smallest key over the symmetries in use, along with the symmetry that gives it
+    QByteArray canonicalKey(const SolverMinefield& minefield, int mineCount, bool populated, Symmetry& symmetry) const;
+
+    bool canonicalizeSymmetries = false;
+
+    mutable QMutex mutex;
+
+    // the solutions are stored in the canonical board's coordinates, the cost of each is roughly its size in bytes
+    mutable QCache<QByteArray, CachedSolution> solutions;
+};
+
+#endif // SOLUTIONCACHE_H
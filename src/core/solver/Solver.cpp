@@ -2,27 +2,34 @@
 
 #include "ChoiceColumn.h"
 #include "ChoiceNode.h"
+#include "ColumnFringe.h"
+#include "LinearCellFlagger.h"
 #include "Minefield.h"
+#include "MineSampler.h"
 #include "ObviousCellFlagger.h"
 #include "PathChooser.h"
 #include "ProgressProxy.h"
+#include "SolverMath.h"
 
 #include <algorithm>
+#include <cmath>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
 
-#define CHECK_CANCELLED if(cancelled) return;
+#define CHECK_CANCELLED if(isStopped()) return;
+
+using boost::multiprecision::cpp_int;
 
 Q_DECLARE_METATYPE(QSharedPointer<Solver>)
 
 Solver::Solver(QSharedPointer<Minefield const> gameMinefield, QHash<Coordinate, double> previousMineChances)
-    : startingMinefield(gameMinefield->getRevealedMinefield(), gameMinefield->getWidth(), gameMinefield->getHeight()),
+    : startingMinefield(gameMinefield->getRevealedMinefield(), gameMinefield->getWidth(), gameMinefield->getHeight()), solutionCacheMinefield(startingMinefield),
       mineCount(gameMinefield->getMineCount()), minefieldPopulated(gameMinefield->isPopulated()), previousMineChances(previousMineChances)
     // clone the passed in minefield so this is thread safe with multiple solves vs the same field
 {
     static int registeredMetatype = qRegisterMetaType<QSharedPointer<Solver>>();
 
-    cancelled = false;
-
     choiceColumns.clear();
     columnCounts.clear();
     chancesToBeMine.clear();
@@ -31,18 +38,83 @@ Solver::Solver(QSharedPointer<Minefield const> gameMinefield, QHash<Coordinate,
     progress = progress.create();
 }
 
+Solver::Solver(const SolverMinefield &revealedMinefield, int mineCount, QHash<Coordinate, double> previousMineChances)
+    : startingMinefield(revealedMinefield), solutionCacheMinefield(revealedMinefield), mineCount(mineCount), previousMineChances(previousMineChances)
+{
+    legalFieldCount = 0;
+
+    progress = progress.create();
+}
+
+Solver::Solver(const SolverMinefield &minefield, const CoordVector &regionPath, PathNumerics numerics)
+    : path(regionPath), startingMinefield(minefield), solutionCacheMinefield(minefield), pathNumerics(numerics), countAllMineTotals(true)
+{
+    // the region can hold any number of mines up to its size, its graph is built for all of them
+    mineCount = path.size();
+    binomials = SolverMath::BinomialTable(path.size());
+
+    progress = progress.create();
+}
+
 Solver::~Solver()
 {
     // don't fully destroy the solver if we're waiting on a future that's interacting with the columns we would destroy
     currentFuture.waitForFinished();
+
+    if(regionCache && speculative)
+    {
+        regionCache->release(this);
+    }
 }
 
 void Solver::computeSolution()
 {
+    if(timeBudget >= 0)
+    {
+        cancellation.setDeadline(QDeadlineTimer(timeBudget));
+    }
+
+    // the previously calculated chances are the most obvious, and the board they leave is what the solution cache knows it by
+    prepareStartingMinefield(previousMineChances);
+
+    solutionCacheMinefield = startingMinefield;
+    solutionCacheMineCount = mineCount;
+
+    if(findCachedSolution())
+    {
+        return;
+    }
+
     flagObviousCells();
     decidePath();
-    buildSolutionGraph();
-    analyzeSolutionGraph();
+
+    if(shouldSample())
+    {
+        sampleSolution();
+    }
+    else if(regionCache && pathNumerics != PathNumerics::Exact)
+    {
+        solveRegions();
+    }
+    else
+    {
+        buildSolutionGraph();
+        analyzeSolutionGraph();
+    }
+
+    if(memoryBudget.isExceeded())
+    {
+        recoverFromMemoryBudget();
+    }
+
+    if(!minefieldPopulated)
+    {// if the minefield was unpopulated there's actually no chance to get a mine because the first click is guaranteed to be not a mine
+        chancesToBeMine.clear();
+        exactChancesToBeMine.clear();
+        chanceErrors.clear();
+    }
+
+    cacheSolution();
 }
 
 const QHash<Coordinate, double> &Solver::getChancesToBeMine() const
@@ -50,6 +122,16 @@ const QHash<Coordinate, double> &Solver::getChancesToBeMine() const
     return chancesToBeMine;
 }
 
+const QHash<Coordinate, cpp_rational> &Solver::getExactChancesToBeMine() const
+{
+    return exactChancesToBeMine;
+}
+
+const QHash<Coordinate, double> &Solver::getChanceErrors() const
+{
+    return chanceErrors;
+}
+
 const QHash<Coordinate, int> &Solver::getColumnCounts() const
 {
     return columnCounts;
@@ -70,17 +152,47 @@ QSharedPointer<ProgressProxy> Solver::getProgress() const
     return progress;
 }
 
-void Solver::flagObviousCells()
+bool Solver::findCachedSolution()
 {
-    CHECK_CANCELLED;
+    if(!solutionCache || pathNumerics == PathNumerics::Exact)
+    {
+        return false;
+    }
 
-    progress->emitProgressStep("Flagging obvious cells");
+    QSharedPointer<CachedSolution> solution = solutionCache->find(solutionCacheMinefield, solutionCacheMineCount, minefieldPopulated);
 
-    // the previously calculated chances are the most obvious
-    prepareStartingMinefield(previousMineChances);
+    if(!solution)
+    {
+        return false;
+    }
+
+    chancesToBeMine = solution->chancesToBeMine;
+    legalFieldCount = solution->legalFieldCount;
+    path = solution->path;
+    columnCounts = solution->columnCounts;
+
+    progress->emitProgressStep("Complete.");
+
+    return true;
+}
+
+void Solver::cacheSolution()
+{
+    // a cancelled solve's chances are missing some cells, and a sampled solve's are only estimates that a later solve might do better on
+    if(!solutionCache || pathNumerics == PathNumerics::Exact || isStopped() || memoryBudgetExceeded || sampled)
+    {
+        return;
+    }
+
+    solutionCache->insert(solutionCacheMinefield, solutionCacheMineCount, minefieldPopulated, {chancesToBeMine, legalFieldCount, path, columnCounts});
+}
 
+void Solver::flagObviousCells()
+{
     CHECK_CANCELLED;
 
+    progress->emitProgressStep("Flagging obvious cells");
+
     ObviousCellFlagger flagger(startingMinefield);
 
     flagger.flagObviousCells();
@@ -90,7 +202,18 @@ void Solver::flagObviousCells()
     // and now we've identified some more obvious ones
     prepareStartingMinefield(flagger.getChancesToBeMine());
 
-    SolverMinefield flaggerMinefield = startingMinefield;
+    CHECK_CANCELLED;
+
+    // solving the count cells together as equations finds more, these are removed from the path just the same
+    // the mine count is one of the equations, which doesn't hold for an unpopulated minefield
+    if(minefieldPopulated)
+    {
+        LinearCellFlagger linearFlagger(startingMinefield, mineCount);
+
+        linearFlagger.flagLinearCells();
+
+        prepareStartingMinefield(linearFlagger.getChancesToBeMine());
+    }
 }
 
 void Solver::decidePath()
@@ -100,18 +223,34 @@ void Solver::decidePath()
     progress->emitProgressStep("Deciding path.");
 
     PathChooser chooser(startingMinefield);
+    chooser.setBeamWidth(pathBeamWidth);
+    chooser.setExpansionLimit(pathExpansionLimit);
+    chooser.setTimeBudget(pathTimeBudget);
 
     chooser.decidePath();
 
     path = chooser.getPath();
     tailPath = chooser.getTailPath();
+    regions = chooser.getRegions();
+    predictedLogColumnSize = chooser.getPredictedLogColumnSize();
+
+    binomials = SolverMath::BinomialTable(path.size() + tailPath.size());
+
+    if(pathNumerics == PathNumerics::Exact)
+    {// no count can be more than the ways to place the mines in the unknown cells, so the primes need to multiply to more than that
+        SolverFloat largestCount = std::max(static_cast<SolverFloat>(1), binomials.choose(path.size() + tailPath.size(), mineCount));
+
+        pathPrimes = SolverMath::largePrimes(boost::multiprecision::log2(largestCount).convert_to<int>() + 2);
+    }
 
-    // there are four computational loops that go over the path size and a cleanup step
-    progress->emitProgressMaximum(5 * path.size());
+    // there are three computational loops that go over the path size, exact counts repeat all three for every prime
+    // checkpoints add a fourth for building the segments again
+    progress->emitProgressMaximum((usesCheckpoints()? 4 : 3) * std::max(1, static_cast<int>(pathPrimes.size())) * path.size());
 
     if(logProgress)
     {
-        qDebug() << "path length" << path.size();
+        qDebug() << "path length" << path.size() << "in" << chooser.getRegionCount() << "independent regions";
+        qDebug() << "largest column predicted to have 2^" << predictedLogColumnSize << "nodes";
     }
 }
 
@@ -121,22 +260,73 @@ void Solver::buildSolutionGraph()
 
     progress->emitProgressStep("Building solution graph.");
 
-    for(Coordinate coord: path)
+    // the states of each column only track the count cells in that column's fringe
+    QList<ColumnFringe> fringes = ColumnFringe::buildFringes(startingMinefield, path, maxDenseStateSpace);
+
+    // with about sqrt(n) columns between checkpoints there are about as many checkpoints as columns in a segment
+    checkpointInterval = usesCheckpoints()? std::max(1, qRound(std::sqrt(path.size() + 1.0))) : 0;
+
+    for(int i = 0; i < path.size(); ++i)
     {
         // build the choice columns
-        choiceColumns.append(QSharedPointer<ChoiceColumn>::create(coord.first, coord.second));
+        choiceColumns.append(createColumn(i, fringes[i], isCheckpoint(i)? &arena : &segmentArena));
     }
 
     // the final column doesn't have a choice anymore and is just the end state where all choices have been made and the board is done
-    choiceColumns.append(QSharedPointer<ChoiceColumn>::create(-1, -1));
+    choiceColumns.append(createColumn(path.size(), fringes.last(), &arena));
+
+    if(logProgress && checkpointInterval > 0)
+    {
+        qDebug() << "keeping every" << checkpointInterval << "columns";
+    }
+
+    linkColumns();
+}
+
+QSharedPointer<ChoiceColumn> Solver::createColumn(int index, const ColumnFringe &fringe, SolverArena *columnArena)
+{
+    QSharedPointer<ChoiceColumn> column;
+
+    if(index < path.size())
+    {
+        column = QSharedPointer<ChoiceColumn>::create(path[index].first, path[index].second, fringe, columnArena);
+        column->setMaxMinesForward(path.size() - index + tailPath.size());
+    }
+    else
+    {
+        column = QSharedPointer<ChoiceColumn>::create(-1, -1, fringe, columnArena);
+        column->setMaxMinesForward(tailPath.size());
+    }
+
+    // exact counts start out modulo the first prime
+    column->setPathNumerics(pathNumerics);
+    column->setBinomialTable(&binomials);
+    column->setCountAllMineTotals(countAllMineTotals);
+    column->setCancellationToken(&cancellation);
+    column->setMemoryBudget(&memoryBudget);
 
+    if(pathNumerics == PathNumerics::Exact)
+    {
+        column->setPathModulus(pathPrimes.first());
+    }
+
+    return column;
+}
+
+void Solver::linkColumns()
+{
     auto initialChoiceColumn = choiceColumns.first();
 
     // the starting node is the current state of the revealed minefield, with a choice pending for the first cell that we will visit
-    QSharedPointer<ChoiceNode> startingNode(new ChoiceNode(startingMinefield, initialChoiceColumn->getX(), initialChoiceColumn->getY()));
-
+    // nothing has been influenced by the path yet, so its fringe state is empty
     // adding the initial node gives us a starting point for the graph
-    initialChoiceColumn->addChoiceNode(startingNode);
+    initialChoiceColumn->createChoiceNode(initialChoiceColumn->getFringe().emptyState());
+    initialChoiceColumn->initializeStartingPathsBack(mineCount);
+
+    // the columns between checkpoints are freed as the graph is built, so their sizes are noted as they're finished
+    columnCounts.insert({initialChoiceColumn->getX(), initialChoiceColumn->getY()}, 1);
+
+    qsizetype maxColumnSize = 1;
 
     // we skip the last one because there's nothing for it to connect to
     for(int i = 0; i < choiceColumns.size() - 1; ++i)
@@ -147,32 +337,43 @@ void Solver::buildSolutionGraph()
         auto nextColumn = choiceColumns[i + 1];
 
         // we traverse each state in the current column and generate the successor states in the next column
-        for(auto choiceNode : currentColumn->getChoiceNodes())
-        {
-            choiceNode->addSuccessorsToNextColumn(nextColumn);
+        awaitFuture(currentColumn->generateSuccessors(*nextColumn, mineCount));
+
+        CHECK_CANCELLED;
+
+        // this also counts the paths back to the start for the next column, since they only depend on the columns built so far
+        awaitFuture(currentColumn->linkSuccessors(*nextColumn, mineCount));
+
+        // every state that the next column will have has been created
+        nextColumn->releaseStateLookup();
+
+        columnCounts.insert({nextColumn->getX(), nextColumn->getY()}, nextColumn->getChoiceNodes().size());
+        maxColumnSize = std::max(maxColumnSize, nextColumn->getChoiceNodes().size());
+
+        if(checkpointInterval > 0 && isCheckpoint(i + 1))
+        {// the columns since the last checkpoint aren't needed until their segment is counted
+            releaseSegment(i / checkpointInterval * checkpointInterval, i + 1);
         }
 
         progress->incrementProgress();
     }
 
-    auto finalColumnChoiceNodes = choiceColumns.last()->getChoiceNodes();
-    if(finalColumnChoiceNodes.size() > 0)
-    {
-        // the only cell of the final choice column needs to account for the tail path cells
-        finalColumnChoiceNodes.first()->setTailPathCellCount(tailPath.size());
-    }
+    CHECK_CANCELLED;
 
-    qsizetype maxColumnSize = 0;
+    // the only cell of the final choice column needs to account for the tail path cells
+    choiceColumns.last()->setTailPathCellCount(tailPath.size());
 
-    for(const auto &column : choiceColumns)
-    {
-        columnCounts.insert({column->getX(), column->getY()}, column->getChoiceNodes().size());
-        maxColumnSize = std::max(maxColumnSize, column->getChoiceNodes().size());
+    for(const QSharedPointer<ChoiceColumn> &column : {choiceColumns.first(), choiceColumns.last()})
+    {// the first and final columns are endpoints
+        assert(column->getChoiceNodes().size() == 1);
+
+        column->getChoiceNodes().first()->setEndpoint(true);
     }
 
     if(logProgress)
     {
         qDebug() << "largest column has" << maxColumnSize << "nodes";
+        qDebug() << "graph holds" << memoryBudget.getUsedBytes() << "bytes";
         qDebug() << "last column has" << choiceColumns.last()->getChoiceNodes().size() << "nodes";
     }
 }
@@ -188,62 +389,63 @@ void Solver::analyzeSolutionGraph()
         qDebug() << "Analyzing...";
     }
 
-    for(const QSharedPointer<ChoiceColumn> &column : {choiceColumns.first(), choiceColumns.last()})
-    {// the final two columns are endpoints
-        assert(column->getChoiceNodes().size() == 1);
-
-        column->getChoiceNodes().first()->setEndpoint(true);
+    if(pathNumerics == PathNumerics::Exact)
+    {
+        countPathsExactly();
     }
-
-    // ultimately we want to calculate for each column, the ways it could be a mine and the ways it could be clear
-    // this requires counting paths through the columns
-    // in order to avoid recursion, we precalculate these path counts for each column
-
-    for(auto column : choiceColumns)
-    {// we start from the beginning and move forward to precompute the paths back since each column depends on the previous
-        CHECK_CANCELLED;
-
-        currentFuture = column->precomputePathsBack(mineCount);
-        currentFuture.waitForFinished();
-
-        progress->incrementProgress();
+    else
+    {
+        countPaths();
     }
 
-    for(auto iter = choiceColumns.rbegin(); iter != choiceColumns.rend(); ++iter)
-    {// we start from the end of the columns and move backward to precompute the paths forward since each column depends on the next
-        CHECK_CANCELLED;
+    CHECK_CANCELLED;
 
-        currentFuture = (*iter)->precomputePathsForward(mineCount);
-        currentFuture.waitForFinished();
+    progress->emitProgressStep("Cleaning up.");
 
-        progress->incrementProgress();
-    }
+    // no longer need the data structure now that we have the final results
+    // the nodes all live in the arena, so this frees a handful of blocks rather than every node one at a time
+    choiceColumns.clear();
+    arena.clear();
+    segmentArena.clear();
+
+    progress->emitProgressStep("Complete.");
 
     if(logProgress)
     {
-        qDebug() << "path count precompution complete";
+        qDebug() << "processed" << choiceColumns.size();
+        qDebug() << "analysis complete";
     }
-    
-    // the total number of valid fields is the number of paths forward from the first node
-    auto validMinefieldCount = choiceColumns.first()->getChoiceNodes().first()->findPathsForward(mineCount);
+}
 
-    for(auto column : choiceColumns)
-    {// calculate all the ways to be
-        CHECK_CANCELLED;
+void Solver::countPaths()
+{
+    // ultimately we want to calculate for each column, the ways it could be a mine and the ways it could be clear
+    // this requires counting paths through the columns
+    calculateWaysToBeMine();
+
+    CHECK_CANCELLED;
+
+    // the total number of valid fields is the number of paths forward from the first node
+    auto validMinefieldCount = choiceColumns.first()->findPathsForward(0, mineCount);
 
+    for(const auto &column : choiceColumns)
+    {
         // set it so we can compute percentages
         column->setValidMinefieldCount(validMinefieldCount);
-        
-        // we compute the ways to be for all columns, including the final column
-        currentFuture = column->calculateWaysToBeMine(mineCount);
-        currentFuture.waitForFinished();
 
         if(column->getX() >= 0 && column->getY() >= 0)
         {// the final column has -1, -1, we don't insert chances for it at its coordinate as it represents all tail path cells
             chancesToBeMine.insert({column->getX(), column->getY()}, column->getPercentChanceToBeMine());
         }
+    }
 
-        progress->incrementProgress();
+    for(const auto &column : choiceColumns)
+    {
+        if(column->isPathRangeExceeded())
+        {// only possible when scaled doubles were asked for, the results would be quietly wrong otherwise
+            qWarning() << "path counts spread too widely for doubles, some chances may be inaccurate";
+            break;
+        }
     }
 
     for(Coordinate coord : tailPath)
@@ -255,62 +457,843 @@ void Solver::analyzeSolutionGraph()
 
     // if all mines are known and passed in as previous state, it's possible for there to only be one choice column at (-1, -1)
     legalFieldCount = std::max(static_cast<SolverFloat>(1), validMinefieldCount);
+}
 
-    if(!minefieldPopulated)
-    {// if the minefield was unpopulated there's actually no chance to get a mine because the first click is guaranteed to be not a mine
-        chancesToBeMine.clear();
+void Solver::calculateWaysToBeMine()
+{
+    if(checkpointInterval > 0)
+    {
+        countPathsInSegments();
+        return;
     }
 
-    progress->emitProgressStep("Cleaning up.");
+    // in order to avoid recursion, we precalculate these path counts for each column
+    // the paths back were already pushed through the columns while the graph was built
+    precomputePathsForward();
 
-    // no longer need the data structure now that we have the final results
-    // this can take some time so we don't want this step before complete
-    while(!choiceColumns.isEmpty())
-    {
-        choiceColumns.removeFirst();
+    CHECK_CANCELLED;
 
-        progress->incrementProgress();
-    }
+    recountPathsIfOutOfRange();
 
-    progress->emitProgressStep("Complete.");
+    CHECK_CANCELLED;
 
     if(logProgress)
     {
-        qDebug() << "processed" << choiceColumns.size();
-        qDebug() << "analysis complete";
+        qDebug() << "path count precompution complete";
+    }
+
+    for(int i = 0; i < choiceColumns.size(); ++i)
+    {// calculate all the ways to be
+        CHECK_CANCELLED;
+
+        // we compute the ways to be for all columns, including the final column
+        awaitFuture(choiceColumns[i]->calculateWaysToBeMine(mineCount, i < choiceColumns.size() - 1? choiceColumns[i + 1].data() : nullptr));
+
+        progress->incrementProgress();
     }
 }
 
-void Solver::prepareStartingMinefield(const QHash<Coordinate, double>& previousMineChances)
+void Solver::countPathsExactly()
 {
-    auto coords = previousMineChances.keys();
+    QVector<quint64> validMinefieldResidues;
+    QVector<QVector<quint64>> waysToBeMineResidues(choiceColumns.size());
 
-    for(const auto& coord : coords)
+    for(int prime = 0; prime < pathPrimes.size(); ++prime)
     {
-        // for clear cells, we only do this if they haven't already been eliminated by becoming count cells
-        if(previousMineChances[coord] == 0 && startingMinefield.getCell(coord.first, coord.second) < 0)
+        if(prime > 0)
+        {// the graph was built counting modulo the first prime, the paths back are redone for the others
+            for(const auto &column : choiceColumns)
+            {
+                column->setPathModulus(pathPrimes[prime]);
+            }
+
+            choiceColumns.first()->initializeStartingPathsBack(mineCount);
+
+            for(int i = 0; i < choiceColumns.size() - 1; ++i)
+            {
+                CHECK_CANCELLED;
+
+                awaitFuture(choiceColumns[i]->pushPathsBack(*choiceColumns[i + 1], mineCount));
+
+                progress->incrementProgress();
+            }
+        }
+
+        precomputePathsForward();
+
+        CHECK_CANCELLED;
+
+        validMinefieldResidues.append(choiceColumns.first()->findPathsForwardResidue(0, mineCount));
+
+        for(int i = 0; i < choiceColumns.size(); ++i)
         {
-            chancesToBeMine[coord] = 0;
-            startingMinefield = startingMinefield.chooseClear(coord.first, coord.second);
+            CHECK_CANCELLED;
+
+            awaitFuture(choiceColumns[i]->calculateWaysToBeMine(mineCount, i < choiceColumns.size() - 1? choiceColumns[i + 1].data() : nullptr));
+
+            waysToBeMineResidues[i].append(choiceColumns[i]->getWaysToBeMineResidue());
+
+            progress->incrementProgress();
         }
+    }
 
-        if(previousMineChances[coord] == 1)
+    // the primes multiply to more than any count can be, so the residues only fit one count
+    cpp_int validMinefieldCount = SolverMath::fromResidues(validMinefieldResidues, pathPrimes);
+
+    for(int i = 0; i < choiceColumns.size(); ++i)
+    {
+        cpp_rational chance = 0;
+
+        if(validMinefieldCount > 0)
         {
-            chancesToBeMine[coord] = 1;
-            startingMinefield = startingMinefield.chooseMine(coord.first, coord.second);
-            mineCount--;
+            chance = cpp_rational(SolverMath::fromResidues(waysToBeMineResidues[i], pathPrimes), validMinefieldCount);
+        }
+
+        QList<Coordinate> coords = {{choiceColumns[i]->getX(), choiceColumns[i]->getY()}};
+
+        if(i == choiceColumns.size() - 1)
+        {// the final column stands in for the tail path cells
+            coords = tailPath;
+        }
+
+        for(Coordinate coord : coords)
+        {
+            exactChancesToBeMine.insert(coord, chance);
+            chancesToBeMine.insert(coord, chance.convert_to<double>());
+        }
+    }
+
+    for(auto iter = chancesToBeMine.constBegin(); iter != chancesToBeMine.constEnd(); ++iter)
+    {// the cells that were known before the graph was built are certain either way
+        if(!exactChancesToBeMine.contains(iter.key()))
+        {
+            exactChancesToBeMine.insert(iter.key(), cpp_rational(iter.value() == 1? 1 : 0));
         }
     }
+
+    // if all mines are known and passed in as previous state, it's possible for there to only be one choice column at (-1, -1)
+    legalFieldCount = std::max(static_cast<SolverFloat>(1), static_cast<SolverFloat>(validMinefieldCount));
 }
 
-void Solver::setLogProgress(bool newLogProgress)
+void Solver::precomputePathsForward()
 {
-    logProgress = newLogProgress;
+    for(int i = choiceColumns.size() - 1; i >= 0; --i)
+    {// we start from the end of the columns and move backward to precompute the paths forward since each column depends on the next
+        CHECK_CANCELLED;
+
+        awaitFuture(choiceColumns[i]->precomputePathsForward(mineCount, i < choiceColumns.size() - 1? choiceColumns[i + 1].data() : nullptr));
+
+        progress->incrementProgress();
+    }
 }
 
-void Solver::cancel()
+void Solver::recountPathsWithBinFloat()
 {
-    cancelled = true;
+    if(logProgress)
+    {
+        qDebug() << "path counts out of range for doubles, recounting with SolverFloat";
+    }
+
+    progress->emitProgressStep("Recounting paths with more range.");
+
+    for(const auto &column : choiceColumns)
+    {
+        column->setPathNumerics(PathNumerics::BinFloat);
+    }
+
+    // the graph is already built, only its counts are redone
+    choiceColumns.first()->initializeStartingPathsBack(mineCount);
+
+    for(int i = 0; i < choiceColumns.size() - 1; ++i)
+    {
+        CHECK_CANCELLED;
 
-    currentFuture.cancel();
+        awaitFuture(choiceColumns[i]->pushPathsBack(*choiceColumns[i + 1], mineCount));
+    }
+
+    // the progress of the forward pass was already counted once
+    progress->emitProgressMaximum(4 * path.size());
+
+    precomputePathsForward();
+}
+
+void Solver::recountPathsIfOutOfRange()
+{
+    if(pathNumerics == PathNumerics::Automatic)
+    {
+        for(const auto &column : choiceColumns)
+        {
+            if(column->isPathRangeExceeded())
+            {// the scaled doubles lost track of some counts, so they're all redone with SolverFloats
+                recountPathsWithBinFloat();
+                break;
+            }
+        }
+    }
+}
+
+bool Solver::usesCheckpoints() const
+{
+    return checkpointing && pathNumerics != PathNumerics::Exact;
+}
+
+bool Solver::isCheckpoint(int index) const
+{
+    return checkpointInterval == 0 || index % checkpointInterval == 0 || index == path.size();
+}
+
+void Solver::countPathsInSegments()
+{
+    auto finalColumn = choiceColumns.last();
+
+    // the final column is always kept, its paths forward are only the tail path's
+    awaitFuture(finalColumn->precomputePathsForward(mineCount, nullptr));
+
+    CHECK_CANCELLED;
+
+    awaitFuture(finalColumn->calculateWaysToBeMine(mineCount, nullptr));
+
+    for(int end = choiceColumns.size() - 1; end > 0;)
+    {
+        int begin = (end - 1) / checkpointInterval * checkpointInterval;
+
+        countSegment(begin, end);
+
+        CHECK_CANCELLED;
+
+        end = begin;
+    }
+
+    if(pathNumerics == PathNumerics::Automatic && finalColumn->getPathNumerics() == PathNumerics::ScaledDouble)
+    {
+        for(const auto &column : choiceColumns)
+        {
+            if(column->isPathRangeExceeded())
+            {// the counts back were freed with the segments, so the graph is built all over again with SolverFloats
+                recountSegmentsWithBinFloat();
+                break;
+            }
+        }
+    }
+}
+
+void Solver::countSegment(int begin, int end)
+{
+    // the end checkpoint's lookup was freed once it was built, so the segment is built into a copy of it instead
+    // the copy finds the same nodes in the same order, so the edges into it fit the checkpoint just as well
+    QSharedPointer<ChoiceColumn> endCopy = createColumn(end, choiceColumns[end]->getFringe(), &segmentArena);
+    endCopy->setPathNumerics(choiceColumns[end]->getPathNumerics());
+
+    for(int i = begin; i < end; ++i)
+    {
+        CHECK_CANCELLED;
+
+        auto currentColumn = choiceColumns[i];
+        auto nextColumn = i + 1 < end? choiceColumns[i + 1] : endCopy;
+
+        awaitFuture(currentColumn->generateSuccessors(*nextColumn, mineCount));
+
+        CHECK_CANCELLED;
+
+        awaitFuture(currentColumn->linkSuccessors(*nextColumn, mineCount));
+
+        nextColumn->releaseStateLookup();
+
+        progress->incrementProgress();
+    }
+
+    assert(endCopy->getChoiceNodes().size() == choiceColumns[end]->getChoiceNodes().size());
+
+    endCopy.clear();
+
+    for(int i = end - 1; i >= begin; --i)
+    {
+        CHECK_CANCELLED;
+
+        awaitFuture(choiceColumns[i]->precomputePathsForward(mineCount, choiceColumns[i + 1].data()));
+
+        progress->incrementProgress();
+    }
+
+    for(int i = begin; i < end; ++i)
+    {
+        CHECK_CANCELLED;
+
+        awaitFuture(choiceColumns[i]->calculateWaysToBeMine(mineCount, choiceColumns[i + 1].data()));
+
+        progress->incrementProgress();
+    }
+
+    releaseSegment(begin, end);
+
+    if(end < choiceColumns.size() - 1)
+    {// nothing reads the end checkpoint's counts anymore, the final column's paths back are still wanted for regions
+        choiceColumns[end]->releaseNodes();
+    }
+}
+
+void Solver::releaseSegment(int begin, int end)
+{
+    for(int i = begin + 1; i < end; ++i)
+    {// the columns between checkpoints are all in the segment arena, which is cleared right after
+        choiceColumns[i]->releaseNodes();
+        choiceColumns[i]->releaseArenaBytes();
+    }
+
+    choiceColumns[begin]->releaseForwardEdges();
+
+    segmentArena.clear();
+}
+
+void Solver::recountSegmentsWithBinFloat()
+{
+    if(logProgress)
+    {
+        qDebug() << "path counts out of range for doubles, rebuilding with SolverFloat";
+    }
+
+    progress->emitProgressStep("Recounting paths with more range.");
+
+    for(const auto &column : choiceColumns)
+    {
+        column->releaseNodes();
+        column->releaseArenaBytes();
+        column->setPathNumerics(PathNumerics::BinFloat);
+    }
+
+    arena.clear();
+    segmentArena.clear();
+
+    // the building and counting are all done a second time
+    progress->emitProgressMaximum(8 * path.size());
+
+    linkColumns();
+
+    CHECK_CANCELLED;
+
+    countPathsInSegments();
+}
+
+bool Solver::shouldSample() const
+{
+    switch(solverEngine)
+    {
+    case SolverEngine::Sampling:
+        return true;
+    case SolverEngine::Graph:
+        return false;
+    case SolverEngine::Automatic:
+    default:
+        return pathNumerics != PathNumerics::Exact && predictedLogColumnSize > samplingThreshold;
+    }
+}
+
+void Solver::sampleSolution()
+{
+    CHECK_CANCELLED;
+
+    progress->emitProgressStep("Sampling minefields.");
+
+    if(logProgress)
+    {
+        qDebug() << "sampling instead of building the graph";
+    }
+
+    sampled = true;
+
+    // a chain per core, and at least two so the chains can be compared for error bars
+    MineSampler sampler(startingMinefield, path, tailPath.size(), mineCount, std::max(2, QThread::idealThreadCount()));
+
+    // the progress is how much of the sampling time has passed
+    progress->emitProgressMaximum(100);
+
+    QElapsedTimer samplingTimer;
+    samplingTimer.start();
+
+    int progressMade = 0;
+
+    // each round is short so a cancel or the end of the sampling time is noticed quickly
+    // until some chain has tallied a legal minefield the chances are only the density of mines, so the sampling goes on past its time for that
+    // but only so far, a board with no legal minefield never gets one
+    auto keepSampling = [&] () {
+        qint64 elapsed = samplingTimer.elapsed();
+
+        return elapsed < samplingTime || (sampler.getSampleCount() == 0 && elapsed < MAX_SAMPLING_TIME_FACTOR * qint64(samplingTime));
+    };
+
+    while(!cancellation.isCancelled() && keepSampling())
+    {
+        sampler.sample(SAMPLING_ROUND_SWEEPS, &cancellation);
+
+        for(; progressMade < std::min<qint64>(100, 100 * samplingTimer.elapsed() / std::max(1, samplingTime)); ++progressMade)
+        {
+            progress->incrementProgress();
+        }
+    }
+
+    if(sampler.getSampleCount() == 0)
+    {// cancelled, or no chain ever found a legal minefield, either way the path's chances are left out like any incomplete solve's
+        legalFieldCount = 0;
+
+        if(logProgress)
+        {
+            qDebug() << "no legal minefield sampled";
+        }
+
+        return;
+    }
+
+    // a sampled chance is never certain, a cell no sample had as a mine might still be one in some minefield the chains never reached
+    // the known cells are left out of the path, so these bounds never hide a certainty the flaggers found
+    double bound = 1.0 / (sampler.getSampleCount() + 2);
+
+    for(int i = 0; i < path.size(); ++i)
+    {
+        chancesToBeMine.insert(path[i], std::clamp(sampler.getChanceToBeMine(i), bound, 1 - bound));
+        chanceErrors.insert(path[i], sampler.getChanceError(i));
+    }
+
+    if(!tailPath.isEmpty())
+    {
+        double tailChance = std::clamp(sampler.getTailChanceToBeMine(), bound, 1 - bound);
+        double tailError = sampler.getTailChanceError();
+
+        for(Coordinate coord : tailPath)
+        {
+            chancesToBeMine.insert(coord, tailChance);
+            chanceErrors.insert(coord, tailError);
+        }
+    }
+
+    if(logProgress)
+    {
+        qDebug() << sampler.getSampleCount() << "legal minefields sampled";
+    }
+
+    // the number of legal minefields isn't known without counting them, so it's left at one
+    legalFieldCount = 1;
+
+    progress->emitProgressStep("Complete.");
+}
+
+void Solver::recoverFromMemoryBudget()
+{
+    memoryBudgetExceeded = true;
+
+    if(logProgress)
+    {
+        qDebug() << "graph went over its memory budget of" << memoryBudget.getLimit() << "bytes";
+    }
+
+    // whatever the graph counted is missing some columns, only the known cells' chances still hold
+    choiceColumns.clear();
+    arena.clear();
+    segmentArena.clear();
+    columnCounts.clear();
+
+    for(const CoordVector& cells : {path, tailPath})
+    {
+        for(Coordinate coord : cells)
+        {
+            chancesToBeMine.remove(coord);
+            exactChancesToBeMine.remove(coord);
+        }
+    }
+
+    // the graph's bytes are all given back, so the budget is clear for whatever comes next
+    memoryBudget.reset();
+
+    if(solverEngine == SolverEngine::Automatic && pathNumerics != PathNumerics::Exact && !cancellation.isCancelled())
+    {
+        progress->emitProgressStep("Memory budget exceeded, sampling instead.");
+
+        sampleSolution();
+    }
+    else
+    {
+        progress->emitProgressStep("Memory budget exceeded, results are incomplete.");
+    }
+}
+
+bool Solver::isStopped() const
+{
+    return cancellation.isCancelled() || memoryBudget.isExceeded();
+}
+
+void Solver::solveRegions()
+{
+    CHECK_CANCELLED;
+
+    progress->emitProgressStep("Solving changed regions.");
+
+    QList<QSharedPointer<const RegionDistribution>> distributions;
+    QList<QByteArray> keys;
+    int unsolvedRegionCount = 0;
+
+    for(const CoordVector &region : regions)
+    {
+        keys.append(RegionCache::regionKey(startingMinefield, region));
+        distributions.append(regionCache->find(keys.last()));
+
+        if(!distributions.last())
+        {
+            ++unsolvedRegionCount;
+        }
+    }
+
+    if(logProgress)
+    {
+        qDebug() << unsolvedRegionCount << "of" << regions.size() << "regions changed";
+    }
+
+    progress->emitProgressMaximum(unsolvedRegionCount);
+
+    for(int i = 0; i < regions.size(); ++i)
+    {
+        if(distributions[i])
+        {
+            continue;
+        }
+
+        QSharedPointer<Solver> solver(new Solver(startingMinefield, regions[i], pathNumerics));
+        solver->cancellation.setDeadline(cancellation.getDeadline());
+        // only one region's graph exists at a time, so each gets the whole budget
+        solver->memoryBudget.setLimit(memoryBudget.getLimit());
+        solver->checkpointing = checkpointing;
+        solver->maxDenseStateSpace = maxDenseStateSpace;
+
+        {
+            QMutexLocker locker(&regionSolverMutex);
+            regionSolver = solver;
+        }
+
+        // checked after the region's solver is visible to cancel, so a cancel can't slip in between
+        CHECK_CANCELLED;
+
+        distributions[i] = solver->computeRegionDistribution();
+
+        {
+            QMutexLocker locker(&regionSolverMutex);
+            regionSolver.clear();
+        }
+
+        if(solver->memoryBudget.isExceeded())
+        {
+            memoryBudget.markExceeded();
+        }
+
+        CHECK_CANCELLED;
+
+        regionCache->insert(keys[i], distributions[i]);
+
+        progress->incrementProgress();
+    }
+
+    // the cache only needs to hold on to this board's regions
+    if(speculative)
+    {
+        regionCache->hold(this, QSet<QByteArray>(keys.begin(), keys.end()));
+    }
+    else
+    {
+        regionCache->retain(QSet<QByteArray>(keys.begin(), keys.end()));
+    }
+
+    combineRegions(distributions);
+
+    progress->emitProgressStep("Complete.");
+}
+
+QSharedPointer<RegionDistribution> Solver::computeRegionDistribution()
+{
+    buildSolutionGraph();
+
+    if(isStopped())
+    {
+        return {};
+    }
+
+    calculateWaysToBeMine();
+
+    if(isStopped())
+    {
+        return {};
+    }
+
+    QSharedPointer<RegionDistribution> distribution = distribution.create();
+
+    // the paths back into the end of the region are the ways to fill it with each count of mines
+    distribution->ways = choiceColumns.last()->getPathsBackByMineCount(0);
+
+    for(int i = 0; i < choiceColumns.size() - 1; ++i)
+    {
+        distribution->waysToBeMine.insert({choiceColumns[i]->getX(), choiceColumns[i]->getY()}, choiceColumns[i]->getWaysToBeMineByMineCount());
+    }
+
+    distribution->columnCounts = columnCounts;
+    distribution->columnCounts.remove({-1, -1});
+
+    choiceColumns.clear();
+    arena.clear();
+    segmentArena.clear();
+
+    return distribution;
+}
+
+void Solver::combineRegions(const QList<QSharedPointer<const RegionDistribution>> &distributions)
+{
+    // the regions only meet through the mine count, so the ways for the whole board combine like the columns at the regions' boundaries do
+    // before[r][k] is the ways for the regions before region r to place k mines
+    // after[r][k] is the ways for region r, the regions after it and the tail path to place the rest of the mines when k were placed before r
+    int regionTotal = distributions.size();
+
+    QVector<QVector<SolverFloat>> before(regionTotal + 1, QVector<SolverFloat>(mineCount + 1, 0));
+    QVector<QVector<SolverFloat>> after(regionTotal + 1, QVector<SolverFloat>(mineCount + 1, 0));
+
+    before[0][0] = 1;
+
+    for(int r = 0; r < regionTotal; ++r)
+    {
+        const QVector<SolverFloat> &ways = distributions[r]->ways;
+
+        for(int k = 0; k <= mineCount; ++k)
+        {
+            if(before[r][k] == 0)
+            {
+                continue;
+            }
+
+            for(int j = 0; j < ways.size() && k + j <= mineCount; ++j)
+            {
+                before[r + 1][k + j] += before[r][k] * ways[j];
+            }
+        }
+    }
+
+    for(int k = 0; k <= mineCount; ++k)
+    {// the tail path takes whatever is left
+        after[regionTotal][k] = binomials.choose(tailPath.size(), mineCount - k);
+    }
+
+    for(int r = regionTotal - 1; r >= 0; --r)
+    {
+        const QVector<SolverFloat> &ways = distributions[r]->ways;
+
+        for(int k = 0; k <= mineCount; ++k)
+        {
+            for(int j = 0; j < ways.size() && k + j <= mineCount; ++j)
+            {
+                after[r][k] += ways[j] * after[r + 1][k + j];
+            }
+        }
+    }
+
+    SolverFloat validMinefieldCount = after[0][0];
+
+    auto chanceOf = [&] (const SolverFloat& ways) {
+        return validMinefieldCount > 0? static_cast<double>(ways / validMinefieldCount) : 0.0;
+    };
+
+    for(int r = 0; r < regionTotal; ++r)
+    {
+        const RegionDistribution &distribution = *distributions[r];
+
+        // the ways for everything outside the region to go along with j mines in it
+        QVector<SolverFloat> outside(distribution.ways.size(), 0);
+
+        for(int j = 0; j < outside.size(); ++j)
+        {
+            for(int k = 0; k + j <= mineCount; ++k)
+            {
+                outside[j] += before[r][k] * after[r + 1][k + j];
+            }
+        }
+
+        for(auto iter = distribution.waysToBeMine.constBegin(); iter != distribution.waysToBeMine.constEnd(); ++iter)
+        {
+            SolverFloat waysToBeMine = 0;
+
+            for(int j = 0; j < iter.value().size() && j < outside.size(); ++j)
+            {
+                waysToBeMine += iter.value()[j] * outside[j];
+            }
+
+            chancesToBeMine.insert(iter.key(), chanceOf(waysToBeMine));
+        }
+
+        for(auto iter = distribution.columnCounts.constBegin(); iter != distribution.columnCounts.constEnd(); ++iter)
+        {
+            columnCounts.insert(iter.key(), iter.value());
+        }
+    }
+
+    if(!tailPath.isEmpty())
+    {// a tail path cell is a mine in the ways that place the rest of the tail's mines in the other tail path cells
+        SolverFloat tailWaysToBeMine = 0;
+
+        for(int k = 0; k < mineCount; ++k)
+        {
+            tailWaysToBeMine += before[regionTotal][k] * binomials.choose(tailPath.size() - 1, mineCount - k - 1);
+        }
+
+        for(Coordinate coord : tailPath)
+        {
+            chancesToBeMine.insert(coord, chanceOf(tailWaysToBeMine));
+        }
+    }
+
+    legalFieldCount = std::max(static_cast<SolverFloat>(1), validMinefieldCount);
+}
+
+void Solver::setRegionCache(QSharedPointer<RegionCache> newRegionCache)
+{
+    regionCache = newRegionCache;
+}
+
+void Solver::setSpeculative(bool newSpeculative)
+{
+    speculative = newSpeculative;
+}
+
+bool Solver::isSpeculative() const
+{
+    return speculative;
+}
+
+void Solver::setSolutionCache(QSharedPointer<SolutionCache> newSolutionCache)
+{
+    solutionCache = newSolutionCache;
+}
+
+void Solver::prepareStartingMinefield(const QHash<Coordinate, double>& previousMineChances)
+{
+    auto coords = previousMineChances.keys();
+
+    for(const auto& coord : coords)
+    {
+        // for clear cells, we only do this if they haven't already been eliminated by becoming count cells
+        if(previousMineChances[coord] == 0 && startingMinefield.getCell(coord.first, coord.second) < 0)
+        {
+            chancesToBeMine[coord] = 0;
+            startingMinefield = startingMinefield.chooseClear(coord.first, coord.second);
+        }
+
+        if(previousMineChances[coord] == 1)
+        {
+            chancesToBeMine[coord] = 1;
+            startingMinefield = startingMinefield.chooseMine(coord.first, coord.second);
+            mineCount--;
+        }
+    }
+}
+
+void Solver::setLogProgress(bool newLogProgress)
+{
+    logProgress = newLogProgress;
+}
+
+void Solver::setTimeBudget(int milliseconds)
+{
+    timeBudget = milliseconds;
+}
+
+bool Solver::isCancelled() const
+{
+    return cancellation.isCancelled();
+}
+
+void Solver::setCheckpointing(bool newCheckpointing)
+{
+    checkpointing = newCheckpointing;
+}
+
+void Solver::setMaxDenseStateSpace(qint64 newMaxDenseStateSpace)
+{
+    maxDenseStateSpace = newMaxDenseStateSpace;
+}
+
+void Solver::setMemoryBudget(qsizetype bytes)
+{
+    memoryBudget.setLimit(bytes);
+}
+
+bool Solver::isMemoryBudgetExceeded() const
+{
+    return memoryBudgetExceeded || memoryBudget.isExceeded();
+}
+
+qsizetype Solver::getPeakGraphBytes() const
+{
+    return memoryBudget.getPeakBytes();
+}
+
+void Solver::awaitFuture(const QFuture<void> &future)
+{
+    {
+        QMutexLocker locker(&futureMutex);
+
+        currentFuture = future;
+    }
+
+    // a cancel that came before the future was stored still reaches the work through the token
+    currentFuture.waitForFinished();
+}
+
+void Solver::setPathNumerics(PathNumerics newPathNumerics)
+{
+    pathNumerics = newPathNumerics;
+}
+
+void Solver::setSolverEngine(SolverEngine newSolverEngine)
+{
+    solverEngine = newSolverEngine;
+}
+
+void Solver::setSamplingThreshold(double newLogColumnSize)
+{
+    samplingThreshold = newLogColumnSize;
+}
+
+void Solver::setPathBeamWidth(int beamWidth)
+{
+    pathBeamWidth = beamWidth;
+}
+
+void Solver::setPathExpansionLimit(int expansions)
+{
+    pathExpansionLimit = expansions;
+}
+
+void Solver::setPathTimeBudget(int milliseconds)
+{
+    pathTimeBudget = milliseconds;
+}
+
+void Solver::setSamplingTime(int milliseconds)
+{
+    samplingTime = milliseconds;
+}
+
+bool Solver::wasSampled() const
+{
+    return sampled;
+}
+
+void Solver::cancel()
+{
+    cancellation.cancel();
+
+    {
+        QMutexLocker locker(&futureMutex);
+
+        // the work already running checks the token, this only keeps the rest from starting
+        currentFuture.cancel();
+    }
+
+    QMutexLocker locker(&regionSolverMutex);
+
+    if(regionSolver)
+    {
+        regionSolver->cancel();
+    }
 }
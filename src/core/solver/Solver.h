@@ -1,11 +1,23 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
+#include "CancellationToken.h"
 #include "ChoiceColumn.h"
+#include "MemoryBudget.h"
+#include "PathChooser.h"
+#include "PathNumerics.h"
+#include "RegionCache.h"
+#include "SolutionCache.h"
+#include "SolverArena.h"
+#include "SolverMath.h"
+#include "SolverEngine.h"
 #include "SolverMinefield.h"
 
+#include <boost/multiprecision/cpp_int.hpp>
+
 #include <QList>
 #include <QHash>
+#include <QMutex>
 #include <QPair>
 #include <QSharedPointer>
 #include <QVector>
@@ -13,6 +25,7 @@
 
 typedef QPair<int, int> Coordinate;
 typedef QVector<Coordinate> CoordVector;
+using boost::multiprecision::cpp_rational;
 
 class ChoiceColumn;
 class Minefield;
@@ -22,11 +35,17 @@ class Solver
 {
 public:
     Solver(QSharedPointer<Minefield const> gameMinefield, QHash<Coordinate, double> previousMineChances = {});
+    // solves a populated board that isn't a game's, like one a reveal might lead to
+    Solver(const SolverMinefield& revealedMinefield, int mineCount, QHash<Coordinate, double> previousMineChances = {});
     ~Solver();
 
     void computeSolution();
 
     const QHash<Coordinate, double> &getChancesToBeMine() const;
+    // only filled in with exact numerics, the same chances as fractions with nothing rounded
+    const QHash<Coordinate, cpp_rational> &getExactChancesToBeMine() const;
+    // only filled in when the chances were sampled, the standard error of each sampled chance
+    const QHash<Coordinate, double> &getChanceErrors() const;
     const QHash<Coordinate, int> &getColumnCounts() const;
     int getLogLegalFieldCount() const;
 
@@ -34,40 +53,190 @@ public:
 
     void setLogProgress(bool newLogProgress);
 
+    // automatic by default, which only pays for SolverFloats on the rare boards whose counts are too spread out for scaled doubles
+    // exact numerics are for checking results, they take a few times as long
+    void setPathNumerics(PathNumerics newPathNumerics);
+
+    // automatic by default, which samples the chances when the path is predicted to need a column of more than 2^threshold nodes
+    // exact numerics are never sampled automatically
+    void setSolverEngine(SolverEngine newSolverEngine);
+    void setSamplingThreshold(double newLogColumnSize);
+    // passed on to the PathChooser, the sampling threshold is checked against the size it predicts for the path it picks
+    // the expansion limit stops its search in the same place every time, a time budget doesn't, so it's off unless it's set
+    void setPathBeamWidth(int beamWidth);
+    void setPathExpansionLimit(int expansions);
+    void setPathTimeBudget(int milliseconds);
+    // how many milliseconds the chains sample for, the error bars shrink with the square root of it
+    // the sampling goes on past it until some chain has found a legal minefield, up to four times as long
+    // a solve that never finds one leaves the path's chances out, like a cancelled one
+    void setSamplingTime(int milliseconds);
+    bool wasSampled() const;
+
+    // with a cache, the independent regions of the path are solved one at a time and then combined with the mine count
+    // any region whose cells and counts are the same as in an earlier solve with the cache is taken from it rather than solved again
+    // exact numerics always solve the whole path at once
+    void setRegionCache(QSharedPointer<RegionCache> newRegionCache);
+    // a speculative solve only holds its regions in the cache until it's destroyed, rather than making the cache forget every other region
+    // so speculations sharing a cache never push out the live board's regions or each other's
+    void setSpeculative(bool newSpeculative);
+    bool isSpeculative() const;
+    // with a cache, a board that was solved before has its results taken from it without building a graph
+    // exact numerics never use the cache, since it doesn't keep the exact chances
+    void setSolutionCache(QSharedPointer<SolutionCache> newSolutionCache);
+
+    // keeps only every sqrt(n)th column of the graph while it's built, the columns in between are built again a segment at a time as the paths are counted
+    // the graph is built about twice over, but at most around 2 sqrt(n) columns are held at once instead of all n
+    // exact numerics always keep the whole graph, since they count it once for every prime
+    void setCheckpointing(bool newCheckpointing);
+
+    // columns with more possible fringe states than this hash their states instead of indexing them densely
+    // both encodings find the same states, so this only changes the speed and memory, 0 hashes every column with a fringe
+    void setMaxDenseStateSpace(qint64 newMaxDenseStateSpace);
+
+    // safe to call from any thread, the solve stops within the time it takes to handle a node or two
     void cancel();
+    // computeSolution gives up once it has taken this many milliseconds, a negative budget never runs out
+    void setTimeBudget(int milliseconds);
+    // set if the solve stopped early, by a cancel or by running out of time, its results are incomplete then
+    bool isCancelled() const;
+
+    // the graph gives up once its nodes, edges, lookups and path counts take more than this many bytes, a negative budget never runs out
+    // the automatic engine samples the chances instead then, otherwise the results are incomplete like a cancelled solve's
+    void setMemoryBudget(qsizetype bytes);
+    // set if the graph outgrew the memory budget, whether or not the chances were sampled instead
+    bool isMemoryBudgetExceeded() const;
+    // the most the graph held at once, in the bytes the budget counts
+    qsizetype getPeakGraphBytes() const;
 
     QSharedPointer<ProgressProxy> getProgress() const;
 
 private:
+    // the sweeps every chain makes between checks of the sampling time
+    static const int SAMPLING_ROUND_SWEEPS = 16;
+    // the sampling runs to this many times its time at most while it waits for a legal minefield
+    static const int MAX_SAMPLING_TIME_FACTOR = 4;
+
+    // solves one region of another solve's path on its own, for every count of mines it could hold
+    Solver(const SolverMinefield& minefield, const CoordVector& regionPath, PathNumerics numerics);
+
     CoordVector path;
     // the tail path is all the unknown cells that have no adjacent count cells, these can be solved with math formulas instead of algorithmic analysis
     CoordVector tailPath;
 
     SolverMinefield startingMinefield;
+    // the board before the flaggers ran, which is what the solution cache knows this solve by
+    SolverMinefield solutionCacheMinefield;
+    int solutionCacheMineCount = 0;
 
     bool logProgress = false;
 
-    bool cancelled = false;
+    PathNumerics pathNumerics = PathNumerics::Automatic;
+
+    SolverEngine solverEngine = SolverEngine::Automatic;
+    double samplingThreshold = 24;
+    int pathBeamWidth = PathChooser::DEFAULT_BEAM_WIDTH;
+    int pathExpansionLimit = PathChooser::DEFAULT_EXPANSION_LIMIT;
+    int pathTimeBudget = -1;
+    int samplingTime = 1000;
+    double predictedLogColumnSize = 0;
+    bool sampled = false;
+
+    QSharedPointer<RegionCache> regionCache;
+    bool speculative = false;
+    QSharedPointer<SolutionCache> solutionCache;
+    QList<CoordVector> regions;
+    // set for the solves of single regions
+    bool countAllMineTotals = false;
+
+    bool checkpointing = false;
+
+    qint64 maxDenseStateSpace = ColumnFringe::MAX_DENSE_STATE_SPACE;
+    // the columns kept are the multiples of this and the final one, it's 0 when every column is kept
+    int checkpointInterval = 0;
+
+    // the region being solved for this solve, so cancelling this cancels it too
+    QSharedPointer<Solver> regionSolver;
+    QMutex regionSolverMutex;
+    // covers every unknown cell, so it's enough for anything the solve needs to choose
+    SolverMath::BinomialTable binomials;
+
+    // the primes the exact counts are found modulo
+    QVector<quint64> pathPrimes;
+
+    CancellationToken cancellation;
+    int timeBudget = -1;
+
+    // declared before the arena and the columns, which give their bytes back to it as they go
+    MemoryBudget memoryBudget;
+    bool memoryBudgetExceeded = false;
 
     int mineCount = 0;
 
     bool minefieldPopulated = true;
 
+    // a cancel from another thread reaches the future through the lock
     QFuture<void> currentFuture;
+    QMutex futureMutex;
 
     QSharedPointer<ProgressProxy> progress;
 
+    // owns every node of the solution graph, declared before the columns so they never outlive it
+    // the columns are built in parallel, which allocates from the arena's shards
+    SolverArena arena{ChoiceColumn::STATE_SHARD_COUNT};
+    // the columns between checkpoints have their own arena, which is cleared each time their segment is done with
+    SolverArena segmentArena{ChoiceColumn::STATE_SHARD_COUNT};
+
     QList<QSharedPointer<ChoiceColumn>> choiceColumns;
 
     QHash<Coordinate, double> chancesToBeMine;
+    QHash<Coordinate, cpp_rational> exactChancesToBeMine;
+    QHash<Coordinate, double> chanceErrors;
     QHash<Coordinate, double> previousMineChances;
     QHash<Coordinate, int> columnCounts;
     SolverFloat legalFieldCount;
 
+    bool findCachedSolution();
+    void cacheSolution();
+
+    // waits for work on the columns, where a cancel can find it
+    void awaitFuture(const QFuture<void>& future);
+
     void flagObviousCells();
     void decidePath();
     void buildSolutionGraph();
+    // the column for the cell at the index of the path, or the final column past its end
+    QSharedPointer<ChoiceColumn> createColumn(int index, const ColumnFringe& fringe, SolverArena* columnArena);
+    // builds the graph out from the starting node, counting the paths back as it goes
+    void linkColumns();
     void analyzeSolutionGraph();
+    void countPaths();
+    // the paths forward and the ways to be a mine of every column, whether the graph is all there or not
+    void calculateWaysToBeMine();
+    void countPathsExactly();
+    void precomputePathsForward();
+    void recountPathsWithBinFloat();
+    void recountPathsIfOutOfRange();
+
+    bool usesCheckpoints() const;
+    bool isCheckpoint(int index) const;
+    // the segments are counted from the end of the path back, since each one needs the paths forward of the checkpoint after it
+    void countPathsInSegments();
+    // builds the columns between the checkpoints again and finds their paths forward and ways to be a mine
+    void countSegment(int begin, int end);
+    // frees the columns between the checkpoints, the checkpoint they start from only keeps its nodes and path counts
+    void releaseSegment(int begin, int end);
+    void recountSegmentsWithBinFloat();
+
+    bool shouldSample() const;
+    void sampleSolution();
+    // frees the graph that outgrew the budget and samples instead if the engine allows it
+    void recoverFromMemoryBudget();
+    // the work stops for a cancel and for going over the memory budget alike
+    bool isStopped() const;
+
+    void solveRegions();
+    QSharedPointer<RegionDistribution> computeRegionDistribution();
+    void combineRegions(const QList<QSharedPointer<const RegionDistribution>>& distributions);
 
     void prepareStartingMinefield(const QHash<Coordinate, double> &previousMineChances);
 };
@@ -0,0 +1,84 @@
+#include "SolverArena.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+// big enough that a block holds thousands of nodes, small enough that a trivial solve doesn't notice it
+static const qsizetype BLOCK_SIZE = 1024 * 1024;
+
+SolverArena::SolverArena(int shardCount)
+{
+    for(int i = 0; i < shardCount; ++i)
+    {// blocks are only allocated on first use, so unused shards cost next to nothing
+        shards.append(new SolverArena());
+    }
+}
+
+SolverArena::~SolverArena()
+{
+    clear();
+
+    qDeleteAll(shards);
+}
+
+SolverArena &SolverArena::getShard(int shard)
+{
+    return *shards[shard];
+}
+
+int SolverArena::getShardCount() const
+{
+    return shards.size();
+}
+
+void SolverArena::clear()
+{
+    // a handful of big frees instead of one per node
+    for(char *block : blocks)
+    {
+        delete[] block;
+    }
+
+    blocks.clear();
+
+    for(SolverArena *shard : shards)
+    {
+        shard->clear();
+    }
+
+    currentBlockSize = 0;
+    currentBlockUsed = 0;
+    allocatedBytes = 0;
+}
+
+qsizetype SolverArena::getAllocatedBytes() const
+{
+    qsizetype total = allocatedBytes;
+
+    for(const SolverArena *shard : shards)
+    {
+        total += shard->getAllocatedBytes();
+    }
+
+    return total;
+}
+
+void *SolverArena::allocate(qsizetype size, qsizetype alignment)
+{
+    // new[] aligns blocks for any fundamental type, so aligning the offset within the block is enough
+    qsizetype offset = (currentBlockUsed + alignment - 1) & ~(alignment - 1);
+
+    if(blocks.isEmpty() || offset + size > currentBlockSize)
+    {// requests bigger than a block get a block of their own
+        currentBlockSize = std::max(BLOCK_SIZE, size);
+        blocks.append(new char[currentBlockSize]);
+
+        offset = 0;
+    }
+
+    currentBlockUsed = offset + size;
+    allocatedBytes += size;
+
+    return blocks.last() + offset;
+}
@@ -0,0 +1,70 @@
+#ifndef SOLVERARENA_H
+#define SOLVERARENA_H
+
+#include <QList>
+#include <QtGlobal>
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// hands out the memory for the solution graph from large contiguous blocks that are freed all at once
+// nothing placed in the arena has its destructor run, so it only accepts trivially destructible types
+// this is not thread safe, allocations have to happen from one thread at a time
+// work that allocates from several threads can use the arena's shards, each of which is an arena of its own
+class SolverArena
+{
+public:
+    explicit SolverArena(int shardCount = 0);
+    ~SolverArena();
+
+    Q_DISABLE_COPY(SolverArena)
+
+    template<typename T, typename... Args>
+    T *create(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // the elements are value initialized
+    template<typename T>
+    T *createArray(qsizetype count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+
+        T *array = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+
+        for(qsizetype i = 0; i < count; ++i)
+        {
+            new (array + i) T();
+        }
+
+        return array;
+    }
+
+    // the shards are created up front so handing them out is safe from any thread
+    // each one still has to be used by one thread at a time
+    SolverArena &getShard(int shard);
+    int getShardCount() const;
+
+    // frees everything that was allocated, shards included, anything still pointing into the arena is left dangling
+    void clear();
+
+    qsizetype getAllocatedBytes() const;
+
+private:
+    QList<char*> blocks;
+
+    QList<SolverArena*> shards;
+
+    qsizetype currentBlockSize = 0;
+    qsizetype currentBlockUsed = 0;
+
+    qsizetype allocatedBytes = 0;
+
+    void *allocate(qsizetype size, qsizetype alignment);
+};
+
+#endif // SOLVERARENA_H
@@ -0,0 +1,15 @@
+#ifndef SOLVERENGINE_H
+#define SOLVERENGINE_H
+
+// how the solver finds the chances
+enum class SolverEngine
+{
+    // builds the graph unless the path is predicted to need a column too large for it, then samples
+    Automatic,
+    // counts every legal minefield with the solution graph, exact up to rounding but the graph can grow exponentially
+    Graph,
+    // samples legal minefields with markov chains, the chances come with error bars and the memory stays small however hard the board is
+    Sampling
+};
+
+#endif // SOLVERENGINE_H
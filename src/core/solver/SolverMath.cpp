@@ -5,6 +5,8 @@
 #include <QMutex>
 #include <QMutexLocker>
 
+#include <algorithm>
+
 using boost::multiprecision::cpp_int;
 
 namespace SolverMath
@@ -22,25 +24,216 @@ SolverFloat choose(int n, int k)
         resultsHash[n] = {1};
     }
 
-    auto newResults = resultsHash[n];
+    QList<SolverFloat> &results = resultsHash[n];
 
     if(n < k || k < 0)
     {
         return 0;
     }
 
-    int startingIndex = std::min(static_cast<int>(newResults.size()) - 1, k);
-    SolverFloat nchoosek = newResults[startingIndex];
+    int startingIndex = std::min(static_cast<int>(results.size()) - 1, k);
+    SolverFloat nchoosek = results[startingIndex];
 
     for(int i = startingIndex + 1; i <= k; ++i)
     {
         nchoosek *= (n + 1 - i) / static_cast<SolverFloat>(i);
-        newResults.append(nchoosek);
+        results.append(nchoosek);
     }
 
-    resultsHash[n] = newResults;
-
     return nchoosek;
 }
 
+BinomialTable::BinomialTable(int maxN)
+{
+    factorialMantissas.resize(maxN + 1);
+    factorialExponents.resize(maxN + 1);
+    inverseFactorialMantissas.resize(maxN + 1);
+
+    int exponent = 0;
+    factorialMantissas[0] = frexp(SolverFloat(1), &exponent);
+    factorialExponents[0] = exponent;
+
+    for(int n = 1; n <= maxN; ++n)
+    {
+        factorialMantissas[n] = frexp(factorialMantissas[n - 1] * n, &exponent);
+        factorialExponents[n] = factorialExponents[n - 1] + exponent;
+    }
+
+    // one division for the largest, every smaller one follows from it
+    // the inverse of n! is 2^-exponent / mantissa, so only the mantissa part is stored
+    inverseFactorialMantissas[maxN] = 1 / factorialMantissas[maxN];
+
+    for(int n = maxN; n > 0; --n)
+    {
+        inverseFactorialMantissas[n - 1] = ldexp(inverseFactorialMantissas[n] * n, factorialExponents[n - 1] - factorialExponents[n]);
+    }
+}
+
+SolverFloat BinomialTable::choose(int n, int k) const
+{
+    if(n < k || k < 0)
+    {
+        return 0;
+    }
+
+    if(n >= factorialMantissas.size())
+    {
+        return SolverMath::choose(n, k);
+    }
+
+    SolverFloat mantissa = factorialMantissas[n] * inverseFactorialMantissas[k] * inverseFactorialMantissas[n - k];
+
+    return ldexp(mantissa, factorialExponents[n] - factorialExponents[k] - factorialExponents[n - k]);
+}
+
+int BinomialTable::getMaxN() const
+{
+    return factorialMantissas.size() - 1;
+}
+
+static quint64 powerModulo(quint64 base, quint64 exponent, quint64 modulus)
+{
+    quint64 result = 1 % modulus;
+
+    base %= modulus;
+
+    for(; exponent > 0; exponent >>= 1)
+    {
+        if(exponent & 1)
+        {
+            result = multiplyModulo(result, base, modulus);
+        }
+
+        base = multiplyModulo(base, base, modulus);
+    }
+
+    return result;
+}
+
+// fermat's little theorem, the modulus has to be prime
+static quint64 inverseModulo(quint64 value, quint64 modulus)
+{
+    return powerModulo(value, modulus - 2, modulus);
+}
+
+quint64 chooseModulo(int n, int k, quint64 modulus)
+{
+    if(n < k || k < 0)
+    {
+        return 0;
+    }
+
+    k = std::min(k, n - k);
+
+    quint64 numerator = 1;
+    quint64 denominator = 1;
+
+    for(int i = 1; i <= k; ++i)
+    {
+        numerator = multiplyModulo(numerator, n + 1 - i, modulus);
+        denominator = multiplyModulo(denominator, i, modulus);
+    }
+
+    return multiplyModulo(numerator, inverseModulo(denominator, modulus), modulus);
+}
+
+// miller rabin with these bases has no false positives below 2^64
+static bool isPrime(quint64 candidate)
+{
+    static const quint64 bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+
+    if(candidate < 2)
+    {
+        return false;
+    }
+
+    for(quint64 base : bases)
+    {
+        if(candidate % base == 0)
+        {
+            return candidate == base;
+        }
+    }
+
+    quint64 odd = candidate - 1;
+    int twos = 0;
+
+    while((odd & 1) == 0)
+    {
+        odd >>= 1;
+        ++twos;
+    }
+
+    for(quint64 base : bases)
+    {
+        quint64 x = powerModulo(base, odd, candidate);
+
+        if(x == 1 || x == candidate - 1)
+        {
+            continue;
+        }
+
+        bool composite = true;
+
+        for(int i = 1; i < twos && composite; ++i)
+        {
+            x = multiplyModulo(x, x, candidate);
+            composite = x != candidate - 1;
+        }
+
+        if(composite)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QVector<quint64> largePrimes(int bits)
+{
+    static QMutex primesMutex;
+    QMutexLocker locker(&primesMutex);
+
+    static QVector<quint64> primes;
+
+    // every prime is above 2^61, so each one adds at least 61 bits to the product
+    int primeCount = std::max(1, (bits + 60) / 61);
+
+    quint64 candidate = primes.isEmpty()? (Q_UINT64_C(1) << 62) - 1 : primes.last() - 2;
+
+    for(; primes.size() < primeCount; candidate -= 2)
+    {
+        if(isPrime(candidate))
+        {
+            primes.append(candidate);
+        }
+    }
+
+    return primes.mid(0, primeCount);
+}
+
+cpp_int fromResidues(const QVector<quint64> &residues, const QVector<quint64> &primes)
+{
+    cpp_int product = 1;
+
+    for(quint64 prime : primes)
+    {
+        product *= prime;
+    }
+
+    cpp_int result = 0;
+
+    for(int i = 0; i < primes.size(); ++i)
+    {
+        // the term for each prime is its residue there and zero modulo all the others
+        cpp_int others = product / primes[i];
+        quint64 othersResidue = static_cast<quint64>(others % primes[i]);
+
+        result += others * multiplyModulo(residues[i], inverseModulo(othersResidue, primes[i]), primes[i]);
+    }
+
+    return result % product;
+}
+
 }
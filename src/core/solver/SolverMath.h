@@ -3,9 +3,62 @@
 
 #include "SolverFloat.h"
 
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <QVector>
+#include <QtGlobal>
+
 namespace SolverMath
 {
+// remembers its results behind a lock, fine for one off uses, the solver itself uses a BinomialTable
 SolverFloat choose(int n, int k);
+
+// n choose k for every n up to a limit, from tables of factorials that are built once and only read after
+// so any number of threads can share one without locking, the solver builds one per solve that covers the board's unknown cells
+class BinomialTable
+{
+public:
+    explicit BinomialTable(int maxN = 0);
+
+    // anything past the limit goes to the locked choose
+    SolverFloat choose(int n, int k) const;
+
+    int getMaxN() const;
+
+private:
+    // a whole factorial passes the largest SolverFloat exponent somewhere past 38000
+    // so each is kept as a mantissa in [0.5, 1) and a power of two, which only meet again in choose
+    QVector<SolverFloat> factorialMantissas;
+    QVector<int> factorialExponents;
+    // kept alongside the factorials so a lookup is two multiplications and no division
+    QVector<SolverFloat> inverseFactorialMantissas;
+};
+
+// exact counting works modulo primes below 2^62, so the sum of two residues never overflows
+inline quint64 addModulo(quint64 a, quint64 b, quint64 modulus)
+{
+    quint64 sum = a + b;
+
+    return sum >= modulus? sum - modulus : sum;
+}
+
+inline quint64 multiplyModulo(quint64 a, quint64 b, quint64 modulus)
+{
+#if defined(__SIZEOF_INT128__)
+    return static_cast<quint64>(static_cast<unsigned __int128>(a) * b % modulus);
+#else
+    return (boost::multiprecision::uint128_t(a) * b % modulus).convert_to<quint64>();
+#endif
+}
+
+// n choose k modulo a prime larger than n
+quint64 chooseModulo(int n, int k, quint64 modulus);
+
+// the largest primes below 2^62, as many as it takes for their product to be at least 2^bits
+QVector<quint64> largePrimes(int bits);
+
+// the chinese remainder theorem, finds the only number below the product of the primes that has each of the residues
+boost::multiprecision::cpp_int fromResidues(const QVector<quint64>& residues, const QVector<quint64>& primes);
 }
 
 #endif // SOLVERMATH_H
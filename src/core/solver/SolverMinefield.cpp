@@ -18,6 +18,25 @@ SolverMinefield SolverMinefield::chooseClear(int x, int y) const
     return chooseCellState(x, y, false);
 }
 
+SolverMinefield SolverMinefield::chooseCount(int x, int y, MineStatus count) const
+{
+    SolverMinefield resultField(*this);
+
+    resultField.minefieldBytes[mapToArray(x, y)] = count;
+
+    return resultField;
+}
+
+void SolverMinefield::markMine(int x, int y)
+{
+    markCellState(x, y, true);
+}
+
+void SolverMinefield::markClear(int x, int y)
+{
+    markCellState(x, y, false);
+}
+
 bool SolverMinefield::isLegal() const
 {
     return legal;
@@ -103,31 +122,36 @@ SolverMinefield SolverMinefield::chooseCellState(int x, int y, bool mine) const
 {
     SolverMinefield resultField(*this);
 
+    resultField.markCellState(x, y, mine);
+
+    return resultField;
+}
+
+void SolverMinefield::markCellState(int x, int y, bool mine)
+{
     auto updateCell = [&] (int i, int j)
     {
         int cellAddress = mapToArray(i, j);
         // the cell we're updating is a count cell
-        if(resultField.minefieldBytes[cellAddress] >= 0)
+        if(minefieldBytes[cellAddress] >= 0)
         {
             if(mine)
             {
                 // since it has a new adjacent mine, we reduce the count in the cell by 1
                 // can't just do -- because of char arithmetic, need to cast to ints to get proper signage
                 // Note: if we go below 0 on the count it will reach the SpecialStatus::Invalid state
-                qint8 updatedValue = static_cast<qint8>(resultField.minefieldBytes[cellAddress]) - 1;
+                qint8 updatedValue = static_cast<qint8>(minefieldBytes[cellAddress]) - 1;
 
-                resultField.minefieldBytes[cellAddress] = updatedValue;
+                minefieldBytes[cellAddress] = updatedValue;
             }
 
-            resultField.legal = resultField.legal && resultField.validateCell(i, j);
+            legal = legal && validateCell(i, j);
         }
     };
 
     // first we mark the cell we're choosing as visited
-    resultField.minefieldBytes[mapToArray(x, y)] = SpecialStatus::Visited;
+    minefieldBytes[mapToArray(x, y)] = SpecialStatus::Visited;
 
-    // then we update all adjacent cells in the result so that their counts correspond to this cell being a mine
-    resultField.traverseAdjacentCells(x, y, updateCell);
-
-    return resultField;
+    // then we update all adjacent cells so that their counts correspond to this cell being a mine
+    traverseAdjacentCells(x, y, updateCell);
 }
@@ -15,6 +15,12 @@ public:
 
     SolverMinefield chooseMine(int x, int y) const;
     SolverMinefield chooseClear(int x, int y) const;
+    // the same minefield with an unknown cell revealed as a count cell, for boards a reveal might lead to
+    SolverMinefield chooseCount(int x, int y, MineStatus count) const;
+
+    // the same choices made on this minefield instead of a copy, for making many of them in a row
+    void markMine(int x, int y);
+    void markClear(int x, int y);
 
     bool isLegal() const;
 
@@ -29,6 +35,7 @@ public:
 private:
     bool validateCell(int x, int y) const;
     SolverMinefield chooseCellState(int x, int y, bool mine) const;
+    void markCellState(int x, int y, bool mine);
 
     bool legal = true;
 
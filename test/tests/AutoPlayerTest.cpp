@@ -2,10 +2,13 @@
 
 #include "AutoPlayer.h"
 #include "Minefield.h"
+#include "Solver.h"
 
 #include <QEventLoop>
 #include <QRandomGenerator>
 
+#include <algorithm>
+
 class AutoPlayerTest : public ::testing::Test
 {
 protected:
@@ -69,3 +72,74 @@ TEST_F(AutoPlayerTest, testWinRate)
     std::cout << "Won " << 100.0 * winCount / gamesPlayed
               << " percent of " << gamesPlayed << " games." << std::endl;
 }
+
+TEST_F(AutoPlayerTest, testSpeculationIsAdopted)
+{
+    int adoptedCount = 0;
+
+    for(int seed = 0; seed < 20; ++seed)
+    {
+        minefield = minefield.create(99, 30, 16, seed);
+        minefield->revealCell(15, 8);
+
+        AutoPlayer autoPlayer(minefield);
+        // only the lowest risk cell, but every count it could show
+        autoPlayer.setSpeculativeCellCount(1);
+        autoPlayer.setSpeculativeOutcomeCount(8);
+
+        QEventLoop calculationLoop;
+        QSharedPointer<Solver> finishedSolver;
+
+        QObject::connect(&autoPlayer, &AutoPlayer::calculationComplete, &calculationLoop, [&] (QSharedPointer<Solver> solver) {
+            finishedSolver = solver;
+            calculationLoop.quit();
+        });
+
+        autoPlayer.queueCalculate();
+        calculationLoop.exec();
+
+        ASSERT_TRUE(finishedSolver);
+        EXPECT_FALSE(finishedSolver->isSpeculative());
+
+        // the same cell the auto player picks, the lowest chance with ties going by position
+        const QHash<Coordinate, double> chances = finishedSolver->getChancesToBeMine();
+        QList<Coordinate> cells;
+
+        for(auto iter = chances.constBegin(); iter != chances.constEnd(); ++iter)
+        {
+            if(iter.value() < 1 && minefield->getCell(iter.key().first, iter.key().second) == SpecialStatus::Unknown)
+            {
+                cells.append(iter.key());
+            }
+        }
+
+        if(cells.isEmpty())
+        {
+            continue;
+        }
+
+        Coordinate cell = *std::min_element(cells.begin(), cells.end(), [&] (const Coordinate& a, const Coordinate& b) {
+            return chances[a] < chances[b] || (chances[a] == chances[b] && a < b);
+        });
+
+        // a mine ends the game and a 0 reveals more than the one cell, neither is speculated on
+        if(minefield->getUnderlyingCell(cell.first, cell.second) <= 0)
+        {
+            continue;
+        }
+
+        autoPlayer.waitForSpeculations();
+
+        minefield->revealCell(cell.first, cell.second);
+
+        autoPlayer.queueCalculate();
+        calculationLoop.exec();
+
+        // the solve that was ready for this board is the one the auto player went with
+        EXPECT_TRUE(finishedSolver->isSpeculative()) << "seed " << seed;
+
+        ++adoptedCount;
+    }
+
+    EXPECT_GT(adoptedCount, 0);
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include "Minefield.h"
+#include "PathChooser.h"
+#include "SolverMinefield.h"
+
+#include <algorithm>
+
+class PathChooserTest : public ::testing::Test
+{
+protected:
+    // a dense board with every other count cell revealed, its regions are big enough for the ordering to matter
+    SolverMinefield hardMinefield(int seed) const
+    {
+        Minefield minefield(480, 40, 40, seed);
+
+        minefield.ensureMinefieldPopulated(0, 0);
+
+        for(int x = 0; x < minefield.getWidth(); x += 2)
+        {
+            for(int y = 0; y < minefield.getHeight(); y += 2)
+            {
+                if(minefield.getUnderlyingCell(x, y) > 0)
+                {
+                    minefield.revealCell(x, y);
+                }
+            }
+        }
+
+        return SolverMinefield(minefield.getRevealedMinefield(), minefield.getWidth(), minefield.getHeight());
+    }
+
+    // every unknown cell next to a count cell, which is what the path has to visit
+    CoordVector countedUnknowns(const SolverMinefield& minefield) const
+    {
+        CoordVector cells;
+
+        for(int x = 0; x < minefield.getWidth(); ++x)
+        {
+            for(int y = 0; y < minefield.getHeight(); ++y)
+            {
+                if(minefield.getCell(x, y) >= 0 || minefield.getCell(x, y) == SpecialStatus::Visited)
+                {
+                    continue;
+                }
+
+                bool nextToCount = false;
+
+                minefield.traverseAdjacentCells(x, y, [&] (int x, int y) -> void {
+                    nextToCount = nextToCount || minefield.getCell(x, y) >= 0;
+                });
+
+                if(nextToCount)
+                {
+                    cells.append({x, y});
+                }
+            }
+        }
+
+        return cells;
+    }
+};
+
+TEST_F(PathChooserTest, testPathVisitsEveryCellOnce)
+{
+    for(int seed = 0; seed < 3; ++seed)
+    {
+        SolverMinefield minefield = hardMinefield(seed);
+
+        PathChooser chooser(minefield);
+        chooser.decidePath();
+
+        CoordVector path = chooser.getPath();
+        CoordVector expectedCells = countedUnknowns(minefield);
+
+        ASSERT_GT(chooser.getRegionCount(), 0);
+        EXPECT_EQ(chooser.getRegionCount(), chooser.getRegions().size());
+
+        // the path is its regions one after another
+        CoordVector regionCells;
+
+        for(const CoordVector& region : chooser.getRegions())
+        {
+            regionCells += region;
+        }
+
+        EXPECT_EQ(path, regionCells) << "seed " << seed;
+
+        std::sort(path.begin(), path.end());
+        std::sort(expectedCells.begin(), expectedCells.end());
+
+        EXPECT_EQ(path, expectedCells) << "seed " << seed;
+    }
+}
+
+TEST_F(PathChooserTest, testBeamIsNoWorseThanGreedy)
+{
+    for(int seed = 0; seed < 3; ++seed)
+    {
+        SolverMinefield minefield = hardMinefield(seed);
+
+        PathChooser beamChooser(minefield);
+        beamChooser.setExpansionLimit(-1);
+        beamChooser.decidePath();
+
+        PathChooser greedyChooser(minefield);
+        greedyChooser.setBeamWidth(1);
+        greedyChooser.decidePath();
+
+        EXPECT_LE(beamChooser.getPredictedLogColumnSize(), greedyChooser.getPredictedLogColumnSize()) << "seed " << seed;
+    }
+}
+
+TEST_F(PathChooserTest, testNoTimeBudgetIsGreedy)
+{
+    SolverMinefield minefield = hardMinefield(0);
+
+    PathChooser noTimeChooser(minefield);
+    noTimeChooser.setTimeBudget(0);
+    noTimeChooser.decidePath();
+
+    PathChooser greedyChooser(minefield);
+    greedyChooser.setBeamWidth(1);
+    greedyChooser.decidePath();
+
+    EXPECT_EQ(noTimeChooser.getPath(), greedyChooser.getPath());
+    EXPECT_EQ(noTimeChooser.getPredictedLogColumnSize(), greedyChooser.getPredictedLogColumnSize());
+}
+
+TEST_F(PathChooserTest, testExpansionLimitGivesTheSamePath)
+{
+    SolverMinefield minefield = hardMinefield(0);
+
+    PathChooser firstChooser(minefield);
+    firstChooser.setExpansionLimit(20000);
+    firstChooser.decidePath();
+
+    PathChooser secondChooser(minefield);
+    secondChooser.setExpansionLimit(20000);
+    secondChooser.decidePath();
+
+    // nothing about the search depends on how long it took, so whether to sample never does either
+    EXPECT_EQ(firstChooser.getPath(), secondChooser.getPath());
+    EXPECT_EQ(firstChooser.getPredictedLogColumnSize(), secondChooser.getPredictedLogColumnSize());
+}
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
+#include "LinearCellFlagger.h"
 #include "Minefield.h"
+#include "ObviousCellFlagger.h"
+#include "ProgressProxy.h"
 #include "Solver.h"
 
 #include <QDebug>
@@ -10,9 +13,102 @@
 #include <QRandomGenerator>
 #include <QtConcurrent/QtConcurrent>
 
+#include <bitset>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+
 class SolverTest : public ::testing::Test
 {
 protected:
+    // one string per row, a digit is a revealed count and anything else is unknown
+    SolverMinefield parseMinefield(const QList<const char*>& rows) const
+    {
+        int width = std::strlen(rows.first());
+        QByteArray bytes;
+
+        for(const char *row : rows)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                bytes.append(std::isdigit(row[x])? static_cast<char>(row[x] - '0') : static_cast<char>(SpecialStatus::Unknown));
+            }
+        }
+
+        return SolverMinefield(bytes, width, rows.size());
+    }
+
+    // count cells scattered over a dense board, with none of them settled by their neighbors
+    // the graph of this board takes far longer to build than any test should wait, and more memory than it has
+    QSharedPointer<Minefield> hardMinefield() const
+    {
+        QSharedPointer<Minefield> minefield(new Minefield(480, 40, 40, 0));
+
+        minefield->ensureMinefieldPopulated(0, 0);
+
+        for(int x = 0; x < minefield->getWidth(); x += 2)
+        {
+            for(int y = 0; y < minefield->getHeight(); y += 2)
+            {
+                if(minefield->getUnderlyingCell(x, y) > 0)
+                {
+                    minefield->revealCell(x, y);
+                }
+            }
+        }
+
+        return minefield;
+    }
+
+    // the expert board of the seed with its middle cell revealed, which most of the comparisons solve
+    QSharedPointer<Minefield> expertMinefield(int seed) const
+    {
+        QSharedPointer<Minefield> minefield(new Minefield(99, 30, 16, seed));
+
+        minefield->revealCell(15, 8);
+
+        return minefield;
+    }
+
+    // both solves have a chance for the same cells and agree on each of them, the callers scope a trace for the seed
+    void expectSameChances(const QHash<Coordinate, double>& expected, const QHash<Coordinate, double>& actual, double tolerance) const
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+
+        for(auto iter = expected.constBegin(); iter != expected.constEnd(); ++iter)
+        {
+            EXPECT_NEAR(iter.value(), actual.value(iter.key(), -1), tolerance) << "cell " << iter.key().first << ", " << iter.key().second;
+        }
+    }
+
+    // a solve that stopped early has only the chances it was sure of, the cells it never got to are left out rather than guessed
+    void expectIncompleteChances(const Solver& solver, QSharedPointer<Minefield> minefield) const
+    {
+        const QHash<Coordinate, double> &chances = solver.getChancesToBeMine();
+
+        int unknownCount = 0;
+
+        for(int x = 0; x < minefield->getWidth(); ++x)
+        {
+            for(int y = 0; y < minefield->getHeight(); ++y)
+            {
+                if(minefield->getCell(x, y) == SpecialStatus::Unknown)
+                {
+                    ++unknownCount;
+                }
+            }
+        }
+
+        EXPECT_LT(chances.size(), unknownCount);
+
+        for(auto iter = chances.constBegin(); iter != chances.constEnd(); ++iter)
+        {
+            EXPECT_TRUE(iter.value() == 0 || iter.value() == 1) << iter.key().first << ", " << iter.key().second;
+        }
+    }
+
     int probabilityBucket(double probability) const
     {
         for(int i = 0; i <= 100; i += 5)
@@ -230,3 +326,719 @@ TEST_F(SolverTest, testSolverProbabilitiesLong)
 {
     testSolverProbabilities(100000);
 }
+
+TEST_F(SolverTest, testPathNumericsAgree)
+{
+    for(int seed = 0; seed < 50; ++seed)
+    {
+        SCOPED_TRACE(testing::Message() << "seed " << seed);
+
+        QSharedPointer<Minefield> minefield = expertMinefield(seed);
+
+        Solver scaledSolver(minefield);
+        scaledSolver.setPathNumerics(PathNumerics::ScaledDouble);
+        scaledSolver.computeSolution();
+
+        Solver binFloatSolver(minefield);
+        binFloatSolver.setPathNumerics(PathNumerics::BinFloat);
+        binFloatSolver.computeSolution();
+
+        Solver exactSolver(minefield);
+        exactSolver.setPathNumerics(PathNumerics::Exact);
+        exactSolver.computeSolution();
+
+        auto exactChances = exactSolver.getChancesToBeMine();
+
+        ASSERT_EQ(exactSolver.getExactChancesToBeMine().size(), exactChances.size());
+
+        // the others only round differently, the doubles have more mantissa bits if anything
+        expectSameChances(exactChances, scaledSolver.getChancesToBeMine(), 1e-6);
+        expectSameChances(exactChances, binFloatSolver.getChancesToBeMine(), 1e-6);
+    }
+}
+
+TEST_F(SolverTest, testHugeBoardChancesAreFinite)
+{
+    // the factorials of this many unknown cells are far past the largest SolverFloat, only their binomials fit
+    QSharedPointer<Minefield> minefield(new Minefield(10000, 250, 200, 7));
+
+    minefield->ensureMinefieldPopulated(125, 100);
+    minefield->revealCell(125, 100);
+
+    Solver solver(minefield);
+    solver.computeSolution();
+
+    auto chances = solver.getChancesToBeMine();
+
+    ASSERT_GT(chances.size(), 40000);
+
+    double chanceSum = 0;
+
+    for(auto iter = chances.constBegin(); iter != chances.constEnd(); ++iter)
+    {
+        ASSERT_TRUE(std::isfinite(iter.value())) << iter.key().first << ", " << iter.key().second;
+        ASSERT_GE(iter.value(), 0);
+        ASSERT_LE(iter.value(), 1);
+
+        chanceSum += iter.value();
+    }
+
+    // every cell is counted, so the chances add up to the mines on the board
+    EXPECT_NEAR(minefield->getMineCount(), chanceSum, 1e-3 * minefield->getMineCount());
+}
+
+TEST_F(SolverTest, testSpeculativeSolveIsAdopted)
+{
+    for(int seed = 0; seed < 20; ++seed)
+    {
+        SCOPED_TRACE(testing::Message() << "seed " << seed);
+
+        QSharedPointer<Minefield> minefield = expertMinefield(seed);
+
+        QSharedPointer<RegionCache> regionCache(new RegionCache);
+
+        Solver liveSolver(minefield);
+        liveSolver.setRegionCache(regionCache);
+        liveSolver.computeSolution();
+
+        int liveRegionCount = regionCache->size();
+
+        QList<Coordinate> countCells;
+
+        for(int x = 0; x < minefield->getWidth(); ++x)
+        {
+            for(int y = 0; y < minefield->getHeight(); ++y)
+            {
+                MineStatus underlying = minefield->getUnderlyingCell(x, y);
+
+                // a 0 reveals its neighbors too, which a speculation never guesses at
+                if(minefield->getCell(x, y) == SpecialStatus::Unknown && underlying > 0)
+                {
+                    countCells.append({x, y});
+                }
+            }
+        }
+
+        if(countCells.size() < 2)
+        {
+            continue;
+        }
+
+        SolverMinefield revealedMinefield(minefield->getRevealedMinefield(), minefield->getWidth(), minefield->getHeight());
+
+        // two speculations share the cache with the live board, like the auto player's
+        QList<QSharedPointer<Solver>> speculations;
+
+        for(const Coordinate& cell : {countCells.first(), countCells.last()})
+        {
+            SolverMinefield outcome = revealedMinefield.chooseCount(cell.first, cell.second, minefield->getUnderlyingCell(cell.first, cell.second));
+
+            QSharedPointer<Solver> speculation(new Solver(outcome, minefield->getMineCount(), liveSolver.getChancesToBeMine()));
+            speculation->setRegionCache(regionCache);
+            speculation->setSpeculative(true);
+            speculation->computeSolution();
+
+            speculations.append(speculation);
+        }
+
+        // neither speculation pushed out the live board's regions
+        EXPECT_GE(regionCache->size(), liveRegionCount);
+
+        // the reveal lands on the first one, which has to give the same chances the solve after the reveal does
+        minefield->revealCell(countCells.first().first, countCells.first().second);
+
+        Solver nextSolver(minefield, liveSolver.getChancesToBeMine());
+        nextSolver.setRegionCache(regionCache);
+        nextSolver.computeSolution();
+
+        auto nextChances = nextSolver.getChancesToBeMine();
+
+        expectSameChances(nextChances, speculations.first()->getChancesToBeMine(), 1e-9);
+
+        // once the speculations are gone the next retain only keeps the live board's regions
+        speculations.clear();
+
+        Solver laterSolver(minefield, liveSolver.getChancesToBeMine());
+        laterSolver.setRegionCache(regionCache);
+        laterSolver.computeSolution();
+
+        EXPECT_LE(regionCache->size(), nextChances.size());
+    }
+}
+
+TEST_F(SolverTest, testSpeculationsKeepTheLiveRegions)
+{
+    RegionCache regionCache;
+    QSharedPointer<const RegionDistribution> distribution(new RegionDistribution);
+
+    const QByteArray live = "live";
+    const QByteArray first = "first";
+    const QByteArray second = "second";
+    const QByteArray next = "next";
+
+    regionCache.insert(live, distribution);
+    regionCache.retain({live});
+
+    // a speculation holds its regions without making the cache forget the live board's
+    regionCache.insert(first, distribution);
+    regionCache.hold(&regionCache, {first, live});
+
+    int otherHolder = 0;
+    regionCache.insert(second, distribution);
+    regionCache.hold(&otherHolder, {second});
+
+    EXPECT_FALSE(regionCache.find(live).isNull());
+    EXPECT_FALSE(regionCache.find(first).isNull());
+    EXPECT_FALSE(regionCache.find(second).isNull());
+
+    // the next live board keeps what's still held too
+    regionCache.insert(next, distribution);
+    regionCache.retain({next});
+
+    EXPECT_FALSE(regionCache.find(live).isNull());
+    EXPECT_FALSE(regionCache.find(first).isNull());
+    EXPECT_FALSE(regionCache.find(second).isNull());
+    EXPECT_FALSE(regionCache.find(next).isNull());
+
+    // released regions go at the next retain
+    regionCache.release(&regionCache);
+    regionCache.release(&otherHolder);
+    regionCache.retain({next});
+
+    EXPECT_TRUE(regionCache.find(live).isNull());
+    EXPECT_TRUE(regionCache.find(first).isNull());
+    EXPECT_TRUE(regionCache.find(second).isNull());
+    EXPECT_FALSE(regionCache.find(next).isNull());
+}
+
+TEST_F(SolverTest, testSampledChancesMatchExact)
+{
+    for(int seed = 0; seed < 5; ++seed)
+    {
+        QSharedPointer<Minefield> minefield(new Minefield(40, 16, 16, seed));
+
+        minefield->revealCell(8, 8);
+
+        Solver exactSolver(minefield);
+        exactSolver.setPathNumerics(PathNumerics::Exact);
+        exactSolver.computeSolution();
+
+        Solver sampledSolver(minefield);
+        sampledSolver.setSolverEngine(SolverEngine::Sampling);
+        sampledSolver.setSamplingTime(500);
+        sampledSolver.computeSolution();
+
+        ASSERT_TRUE(sampledSolver.wasSampled());
+
+        auto exactChances = exactSolver.getChancesToBeMine();
+        auto sampledChances = sampledSolver.getChancesToBeMine();
+        auto errors = sampledSolver.getChanceErrors();
+
+        ASSERT_EQ(exactChances.size(), sampledChances.size());
+
+        for(auto iter = errors.constBegin(); iter != errors.constEnd(); ++iter)
+        {// the errors are standard errors, every cell of the board is checked so this leaves room for the odd unlucky one
+            double error = std::abs(sampledChances[iter.key()] - exactChances.value(iter.key(), -1));
+
+            EXPECT_LE(error, 5 * iter.value() + 0.01) << "seed " << seed << " cell " << iter.key().first << ", " << iter.key().second;
+        }
+    }
+}
+
+TEST_F(SolverTest, testSamplingWithoutSamplesIsIncomplete)
+{
+    QSharedPointer<Minefield> minefield(new Minefield(40, 16, 16, 1));
+
+    minefield->revealCell(8, 8);
+
+    Solver solver(minefield);
+    solver.setSolverEngine(SolverEngine::Sampling);
+
+    // cancelled as soon as the sampling starts, before any chain can burn in
+    QObject::connect(solver.getProgress().data(), &ProgressProxy::progressStep, [&solver] (const QString& step) {
+        if(step.startsWith("Sampling"))
+        {
+            solver.cancel();
+        }
+    });
+
+    solver.computeSolution();
+
+    // the mine density isn't passed off as chances, only the cells the flaggers found are known
+    EXPECT_TRUE(solver.isCancelled());
+    EXPECT_TRUE(solver.getChanceErrors().isEmpty());
+
+    auto chances = solver.getChancesToBeMine();
+
+    for(auto iter = chances.constBegin(); iter != chances.constEnd(); ++iter)
+    {
+        EXPECT_TRUE(iter.value() == 0 || iter.value() == 1) << iter.key().first << ", " << iter.key().second;
+    }
+}
+
+TEST_F(SolverTest, testSamplingGivesUpOnImpossibleBoards)
+{
+    // a 3 with only two unknowns around it, and more mines than cells on a board with no counts at all
+    QList<QPair<SolverMinefield, int>> boards = {{parseMinefield({"?3?"}), 2}, {parseMinefield({"???"}), 5}};
+
+    for(const auto& board : boards)
+    {
+        Solver solver(board.first, board.second);
+        solver.setSolverEngine(SolverEngine::Sampling);
+        solver.setSamplingTime(50);
+        solver.computeSolution();
+
+        // no chain ever finds a legal minefield, so there's nothing to report but it still stops
+        EXPECT_TRUE(solver.wasSampled());
+        EXPECT_FALSE(solver.isCancelled());
+        EXPECT_TRUE(solver.getChanceErrors().isEmpty());
+
+        auto chances = solver.getChancesToBeMine();
+
+        for(auto iter = chances.constBegin(); iter != chances.constEnd(); ++iter)
+        {
+            EXPECT_TRUE(iter.value() == 0 || iter.value() == 1) << iter.key().first << ", " << iter.key().second;
+        }
+    }
+}
+
+TEST_F(SolverTest, testDenseAndHashedStatesAgree)
+{
+    for(int seed = 0; seed < 30; ++seed)
+    {
+        SCOPED_TRACE(testing::Message() << "seed " << seed);
+
+        QSharedPointer<Minefield> minefield = expertMinefield(seed);
+
+        Solver denseSolver(minefield);
+        denseSolver.computeSolution();
+
+        // every column with a fringe hashes its states
+        Solver hashedSolver(minefield);
+        hashedSolver.setMaxDenseStateSpace(0);
+        hashedSolver.computeSolution();
+
+        // a mix of both, so some columns go from one encoding to the other
+        Solver mixedSolver(minefield);
+        mixedSolver.setMaxDenseStateSpace(64);
+        mixedSolver.computeSolution();
+
+        // the same states are found either way, so the columns are the same size
+        EXPECT_EQ(denseSolver.getColumnCounts(), hashedSolver.getColumnCounts());
+        EXPECT_EQ(denseSolver.getColumnCounts(), mixedSolver.getColumnCounts());
+        EXPECT_EQ(denseSolver.getLogLegalFieldCount(), hashedSolver.getLogLegalFieldCount());
+
+        // the paths may be added up in another order, which only changes the rounding
+        expectSameChances(denseSolver.getChancesToBeMine(), hashedSolver.getChancesToBeMine(), 1e-9);
+        expectSameChances(denseSolver.getChancesToBeMine(), mixedSolver.getChancesToBeMine(), 1e-9);
+    }
+}
+
+TEST_F(SolverTest, testPairRuleFlagsOneTwoPattern)
+{
+    // no count here says anything about its unknowns on its own, each 2 has to be compared with the 1 beside it
+    SolverMinefield minefield = parseMinefield({"????",
+                                                "1221"});
+
+    ObviousCellFlagger flagger(minefield);
+    flagger.flagObviousCells();
+
+    auto chances = flagger.getChancesToBeMine();
+
+    // the 2 has one more unknown than the 1 next to it, and needs one more mine, so that unknown is a mine
+    EXPECT_EQ(4, chances.size());
+    EXPECT_EQ(0, chances.value({0, 0}, -1));
+    EXPECT_EQ(1, chances.value({1, 0}, -1));
+    EXPECT_EQ(1, chances.value({2, 0}, -1));
+    EXPECT_EQ(0, chances.value({3, 0}, -1));
+}
+
+TEST_F(SolverTest, testLinearFlaggerAgreesWithBruteForce)
+{
+    int flaggedCount = 0;
+
+    for(int seed = 0; seed < 200; ++seed)
+    {
+        // small enough to try every way to place the mines
+        QSharedPointer<Minefield> minefield(new Minefield(6, 5, 4, seed));
+
+        minefield->ensureMinefieldPopulated(0, 0);
+        minefield->revealCell(0, 0);
+
+        std::mt19937 random(seed);
+
+        for(int i = 0; i < 2; ++i)
+        {
+            int x = random() % minefield->getWidth();
+            int y = random() % minefield->getHeight();
+
+            if(minefield->getUnderlyingCell(x, y) != SpecialStatus::Mine)
+            {
+                minefield->revealCell(x, y);
+            }
+        }
+
+        SolverMinefield solverMinefield(minefield->getRevealedMinefield(), minefield->getWidth(), minefield->getHeight());
+
+        LinearCellFlagger flagger(solverMinefield, minefield->getMineCount());
+        flagger.flagLinearCells();
+
+        auto chances = flagger.getChancesToBeMine();
+
+        CoordVector unknowns;
+        QList<QPair<int, quint32>> counts;
+
+        solverMinefield.traverseCells([&] (int x, int y) {
+            if(solverMinefield.getCell(x, y) < 0)
+            {
+                unknowns.append({x, y});
+            }
+        });
+
+        solverMinefield.traverseCells([&] (int x, int y) {
+            if(solverMinefield.getCell(x, y) >= 0)
+            {
+                quint32 adjacentUnknowns = 0;
+
+                solverMinefield.traverseAdjacentCells(x, y, [&] (int adjacentX, int adjacentY) {
+                    int index = unknowns.indexOf({adjacentX, adjacentY});
+
+                    if(index >= 0)
+                    {
+                        adjacentUnknowns |= 1u << index;
+                    }
+                });
+
+                counts.append({solverMinefield.getCell(x, y), adjacentUnknowns});
+            }
+        });
+
+        // a cell that's a mine in every legal minefield has all bits set here, one that's always clear has none
+        quint32 alwaysMine = ~0u;
+        quint32 everMine = 0;
+
+        for(quint32 mines = 0; mines < (1u << unknowns.size()); ++mines)
+        {
+            bool legal = std::bitset<32>(mines).count() == static_cast<size_t>(minefield->getMineCount());
+
+            for(int i = 0; legal && i < counts.size(); ++i)
+            {
+                legal = static_cast<int>(std::bitset<32>(mines & counts[i].second).count()) == counts[i].first;
+            }
+
+            if(legal)
+            {
+                alwaysMine &= mines;
+                everMine |= mines;
+            }
+        }
+
+        for(auto iter = chances.constBegin(); iter != chances.constEnd(); ++iter)
+        {// whatever it flags has to hold in every legal minefield, it doesn't have to find everything
+            int index = unknowns.indexOf(iter.key());
+
+            ASSERT_GE(index, 0) << "seed " << seed << " flagged a revealed cell";
+
+            quint32 bit = 1u << index;
+
+            if(iter.value() == 1)
+            {
+                EXPECT_TRUE(alwaysMine & bit) << "seed " << seed << " cell " << iter.key().first << ", " << iter.key().second;
+            }
+            else
+            {
+                EXPECT_FALSE(everMine & bit) << "seed " << seed << " cell " << iter.key().first << ", " << iter.key().second;
+            }
+
+            ++flaggedCount;
+        }
+    }
+
+    // the boards are small enough that the mine count settles plenty of cells
+    EXPECT_GT(flaggedCount, 0);
+}
+
+TEST_F(SolverTest, testRegionCacheMatchesFullSolve)
+{
+    for(int seed = 0; seed < 10; ++seed)
+    {
+        SCOPED_TRACE(testing::Message() << "seed " << seed);
+
+        QSharedPointer<Minefield> minefield = expertMinefield(seed);
+
+        QSharedPointer<RegionCache> regionCache(new RegionCache);
+        std::mt19937 random(seed);
+
+        // each reveal only changes a region or two, the rest of them come from the cache
+        for(int reveal = 0; reveal < 8; ++reveal)
+        {
+            SCOPED_TRACE(testing::Message() << "reveal " << reveal);
+
+            Solver regionSolver(minefield);
+            regionSolver.setRegionCache(regionCache);
+            regionSolver.computeSolution();
+
+            Solver fullSolver(minefield);
+            fullSolver.computeSolution();
+
+            auto fullChances = fullSolver.getChancesToBeMine();
+
+            expectSameChances(fullChances, regionSolver.getChancesToBeMine(), 1e-6);
+
+            CoordVector safeCells;
+
+            for(auto iter = fullChances.constBegin(); iter != fullChances.constEnd(); ++iter)
+            {
+                if(minefield->getCell(iter.key().first, iter.key().second) == SpecialStatus::Unknown
+                        && minefield->getUnderlyingCell(iter.key().first, iter.key().second) != SpecialStatus::Mine)
+                {
+                    safeCells.append(iter.key());
+                }
+            }
+
+            if(safeCells.isEmpty())
+            {
+                break;
+            }
+
+            // the hash's order changes from run to run, the seed alone should pick the cell
+            std::sort(safeCells.begin(), safeCells.end());
+
+            Coordinate cell = safeCells[random() % safeCells.size()];
+            minefield->revealCell(cell.first, cell.second);
+        }
+    }
+}
+
+TEST_F(SolverTest, testSymmetricSolutionsMapBack)
+{
+    for(int seed = 0; seed < 10; ++seed)
+    {
+        // not square, so a transposed board has its width and height swapped
+        QSharedPointer<Minefield> minefield(new Minefield(40, 16, 12, seed));
+
+        minefield->revealCell(8, 6);
+
+        int width = minefield->getWidth();
+        int height = minefield->getHeight();
+
+        SolverMinefield original(minefield->getRevealedMinefield(), width, height);
+
+        QSharedPointer<SolutionCache> solutionCache(new SolutionCache);
+        solutionCache->setCanonicalizeSymmetries(true);
+
+        // every cell gets a chance no other cell has, so a cell mapped to the wrong place is caught
+        // no solve would come up with these, so they also show the other boards were answered from the cache
+        CachedSolution markedSolution;
+        markedSolution.legalFieldCount = 1;
+
+        original.traverseCells([&] (int x, int y) {
+            markedSolution.chancesToBeMine.insert({x, y}, (x + y * width) / 1000.0);
+        });
+
+        solutionCache->insert(original, minefield->getMineCount(), true, markedSolution);
+
+        auto originalChances = markedSolution.chancesToBeMine;
+
+        for(int symmetry = 1; symmetry < 8; ++symmetry)
+        {
+            bool flipX = symmetry & 1;
+            bool flipY = symmetry & 2;
+            bool transpose = symmetry & 4;
+
+            auto mapCoordinate = [&] (const Coordinate& coord) -> Coordinate {
+                int x = flipX? width - 1 - coord.first : coord.first;
+                int y = flipY? height - 1 - coord.second : coord.second;
+
+                return transpose? Coordinate(y, x) : Coordinate(x, y);
+            };
+
+            int mappedWidth = transpose? height : width;
+            QByteArray mappedBytes(width * height, 0);
+
+            original.traverseCells([&] (int x, int y) {
+                Coordinate mapped = mapCoordinate({x, y});
+                mappedBytes[mapped.first + mapped.second * mappedWidth] = original.getCell(x, y);
+            });
+
+            SolverMinefield mappedMinefield(mappedBytes, mappedWidth, transpose? width : height);
+
+            // answered from the original board's solution
+            Solver mappedSolver(mappedMinefield, minefield->getMineCount());
+            mappedSolver.setSolutionCache(solutionCache);
+            mappedSolver.computeSolution();
+
+            auto mappedChances = mappedSolver.getChancesToBeMine();
+
+            ASSERT_EQ(originalChances.size(), mappedChances.size());
+
+            for(auto iter = originalChances.constBegin(); iter != originalChances.constEnd(); ++iter)
+            {
+                Coordinate mapped = mapCoordinate(iter.key());
+
+                EXPECT_EQ(iter.value(), mappedChances.value(mapped, -1)) << "seed " << seed << " symmetry " << symmetry << " cell " << iter.key().first << ", " << iter.key().second;
+            }
+        }
+    }
+}
+
+TEST_F(SolverTest, testCancelStopsSolve)
+{
+    QSharedPointer<Minefield> minefield = hardMinefield();
+
+    Solver solver(minefield);
+    solver.setSolverEngine(SolverEngine::Graph);
+
+    std::thread canceller([&solver] () {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        solver.cancel();
+    });
+
+    solver.computeSolution();
+
+    canceller.join();
+
+    EXPECT_TRUE(solver.isCancelled());
+    expectIncompleteChances(solver, minefield);
+}
+
+TEST_F(SolverTest, testTimeBudgetStopsSolve)
+{
+    QSharedPointer<Minefield> minefield = hardMinefield();
+
+    Solver solver(minefield);
+    solver.setSolverEngine(SolverEngine::Graph);
+    solver.setTimeBudget(100);
+
+    solver.computeSolution();
+
+    EXPECT_TRUE(solver.isCancelled());
+    expectIncompleteChances(solver, minefield);
+}
+
+TEST_F(SolverTest, testMemoryBudgetRecovers)
+{
+    for(int seed = 0; seed < 5; ++seed)
+    {
+        SCOPED_TRACE(testing::Message() << "seed " << seed);
+
+        QSharedPointer<Minefield> minefield = expertMinefield(seed);
+
+        Solver unlimitedSolver(minefield);
+        unlimitedSolver.setSolverEngine(SolverEngine::Graph);
+        unlimitedSolver.computeSolution();
+
+        auto unlimitedChances = unlimitedSolver.getChancesToBeMine();
+        qsizetype peakBytes = unlimitedSolver.getPeakGraphBytes();
+
+        ASSERT_GT(peakBytes, 0);
+
+        // a budget the graph fits in changes nothing, the threads can interleave their allocations differently so it's given some room
+        Solver roomySolver(minefield);
+        roomySolver.setSolverEngine(SolverEngine::Graph);
+        roomySolver.setMemoryBudget(2 * peakBytes);
+        roomySolver.computeSolution();
+
+        EXPECT_FALSE(roomySolver.isMemoryBudgetExceeded());
+
+        expectSameChances(unlimitedChances, roomySolver.getChancesToBeMine(), 1e-9);
+
+        // with only the graph allowed, running out leaves the results incomplete
+        Solver graphSolver(minefield);
+        graphSolver.setSolverEngine(SolverEngine::Graph);
+        graphSolver.setMemoryBudget(peakBytes / 2);
+        graphSolver.computeSolution();
+
+        EXPECT_TRUE(graphSolver.isMemoryBudgetExceeded());
+        EXPECT_FALSE(graphSolver.wasSampled());
+
+        auto graphChances = graphSolver.getChancesToBeMine();
+
+        for(auto iter = graphChances.constBegin(); iter != graphChances.constEnd(); ++iter)
+        {// only the cells the flaggers settled are left
+            EXPECT_TRUE(iter.value() == 0 || iter.value() == 1);
+        }
+
+        // the automatic engine samples instead, which gives every cell a chance again
+        Solver automaticSolver(minefield);
+        automaticSolver.setMemoryBudget(peakBytes / 2);
+        automaticSolver.setSamplingTime(200);
+        automaticSolver.computeSolution();
+
+        EXPECT_TRUE(automaticSolver.isMemoryBudgetExceeded());
+        EXPECT_TRUE(automaticSolver.wasSampled());
+        EXPECT_FALSE(automaticSolver.isCancelled());
+
+        auto sampledChances = automaticSolver.getChancesToBeMine();
+        auto errors = automaticSolver.getChanceErrors();
+
+        ASSERT_EQ(unlimitedChances.size(), sampledChances.size());
+
+        for(auto iter = errors.constBegin(); iter != errors.constEnd(); ++iter)
+        {// the same allowance as for any sampled chances
+            EXPECT_NEAR(unlimitedChances.value(iter.key(), -1), sampledChances[iter.key()], 5 * iter.value() + 0.01);
+        }
+    }
+}
+
+TEST_F(SolverTest, testCheckpointsMatchFullGraph)
+{
+    for(int seed = 0; seed < 20; ++seed)
+    {
+        SCOPED_TRACE(testing::Message() << "seed " << seed);
+
+        QSharedPointer<Minefield> minefield = expertMinefield(seed);
+
+        for(PathNumerics numerics : {PathNumerics::ScaledDouble, PathNumerics::BinFloat})
+        {
+            Solver fullSolver(minefield);
+            fullSolver.setSolverEngine(SolverEngine::Graph);
+            fullSolver.setPathNumerics(numerics);
+            fullSolver.computeSolution();
+
+            Solver checkpointSolver(minefield);
+            checkpointSolver.setSolverEngine(SolverEngine::Graph);
+            checkpointSolver.setPathNumerics(numerics);
+            checkpointSolver.setCheckpointing(true);
+            checkpointSolver.computeSolution();
+
+            // the columns between checkpoints are built again from the same states, so they come out the same
+            EXPECT_EQ(fullSolver.getColumnCounts(), checkpointSolver.getColumnCounts());
+            EXPECT_EQ(fullSolver.getLogLegalFieldCount(), checkpointSolver.getLogLegalFieldCount());
+
+            expectSameChances(fullSolver.getChancesToBeMine(), checkpointSolver.getChancesToBeMine(), 1e-9);
+        }
+    }
+}
+
+TEST_F(SolverTest, testCheckpointsHoldLessOfTheGraph)
+{
+    // a long path with wide columns, where holding only some of them matters
+    QSharedPointer<Minefield> minefield(new Minefield(300, 60, 30, 3));
+
+    minefield->ensureMinefieldPopulated(0, 0);
+
+    for(int x = 0; x < minefield->getWidth(); x += 3)
+    {
+        for(int y = 0; y < minefield->getHeight(); y += 3)
+        {
+            if(minefield->getUnderlyingCell(x, y) > 0)
+            {
+                minefield->revealCell(x, y);
+            }
+        }
+    }
+
+    Solver fullSolver(minefield);
+    fullSolver.setSolverEngine(SolverEngine::Graph);
+    fullSolver.computeSolution();
+
+    Solver checkpointSolver(minefield);
+    checkpointSolver.setSolverEngine(SolverEngine::Graph);
+    checkpointSolver.setCheckpointing(true);
+    checkpointSolver.computeSolution();
+
+    EXPECT_LT(checkpointSolver.getPeakGraphBytes(), fullSolver.getPeakGraphBytes());
+
+    expectSameChances(fullSolver.getChancesToBeMine(), checkpointSolver.getChancesToBeMine(), 1e-9);
+}